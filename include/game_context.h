@@ -0,0 +1,167 @@
+/*
+ * game_context.h - Per-session game state
+ *
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file game_context.h
+ * @brief Per-session game state
+ *
+ * Everything that changes while a game is played - progress, sprite
+ * registers, ghost AI, the live copy of the maze, dirty-cell tracking,
+ * key buffer and frame counters - lives in a game_context_t, so one
+ * process can run many independent games. Assets and derived tables
+ * that never change after loading (tiles, sprites, blank_maze,
+ * inside_wall, options) stay global and are shared by every session.
+ *
+ * The game code reaches the state through the current context,
+ * game_ctx, which is thread-local: each thread drives one session at a
+ * time. The top-level entry points (gamecycle(), gametick(),
+ * gamelogic(), gamerender(), gameinput(), ...) take the context to run
+ * and make it current. The game modules that still say `score` or
+ * `sprite_register_x[HERO]` for the current context's fields include
+ * game_context_aliases.h to do so; nothing else sees those names.
+ */
+
+#ifndef GAME_CONTEXT_H
+#define GAME_CONTEXT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game_state.h"
+#include "sprite_state.h"
+
+struct game_context {
+    /* progress */
+    int           level;
+    int           intermission;
+    int           intermission_shown;
+    int           cycles;
+    int           score;
+    int           dots;
+    int           points;
+    int           lives_used;
+    int           earned;
+    int           dying;
+    int           dead;
+    int           deadpan;
+    int           oldplayer;
+    int           player;
+    long          pellet_timer;
+    long          pellet_time;
+    long          myman_intro;
+    unsigned long myman_start;
+    unsigned long myman_demo;
+    unsigned long myman_demo_setup;
+    int           munched;
+    long          winning;
+    int           ghost_eaten_timer;
+    bool          paused;
+    long          intermission_running;
+    int           need_reset;
+    int           level_init; /**< sprites cleared since the last reset */
+
+    /* sprites and ghost AI */
+    uint8_t sprite_register[SPRITE_REGISTERS];
+    int     sprite_register_frame[SPRITE_REGISTERS];
+    int     sprite_register_x[SPRITE_REGISTERS];
+    int     sprite_register_y[SPRITE_REGISTERS];
+    int     sprite_register_used[SPRITE_REGISTERS];
+    int     sprite_register_timer[SPRITE_REGISTERS];
+    int     sprite_register_color[SPRITE_REGISTERS];
+    int     ghost_dir[MAXGHOSTS];
+    int     ghost_mem[MAXGHOSTS];
+    int     ghost_man[MAXGHOSTS];
+    int     ghost_timer[MAXGHOSTS];
+    int     hero_dir;
+
+    /* gamepilot() wander state; 0 keeps the scripted demo pilot */
+    uint32_t pilot_rng;
+
+    /* live maze (dots get eaten) and what needs redrawing */
+    char*    maze;
+    char*    maze_color;
+    int      maze_level;
+    uint64_t* dirty_cell;
+    bool      all_dirty;
+    bool      status_dirty; /* status area needs stale cells blanked */
+
+    /* route tables for the current level of the live maze, rebuilt by
+     * maze_routes(): the open run through each cell (0 where blocked),
+     * numbered by where the run starts, so "all open between two cells
+     * of a row/column" is one comparison, the tile each zap cell sends
+     * the hero to, and the number of steps from each cell back to the
+     * ghost pen that ghost eyes follow home; route_level is
+     * maze_level + 1 while they match the maze and 0 once a maze write
+     * makes them stale */
+    uint16_t* row_run;
+    uint16_t* col_run;
+    uint16_t* zap_to;
+    uint16_t* home_dist;
+    int       route_level;
+
+    /* visual glyph cache for the current level of the live maze, built
+     * by maze_glyphs(): maze_visual() of each cell in the low byte and
+     * the tile it is drawn with, after the fallback_cp437 chain, in the
+     * high byte; glyph_level is maze_level + 1 while it is valid, cell
+     * writes refresh their own entry and bulk maze copies zero it;
+     * pellet_cell has a bit (laid out like dirty_cell) for every cell
+     * that held a pellet since the cache was built */
+    uint16_t* maze_glyph;
+    uint64_t* pellet_cell;
+    int       glyph_level;
+
+    /* per-frame render scratch: which sprite registers (one bit each)
+     * can draw on each maze cell */
+    uint64_t* sprite_cells;
+
+    /* input, frame pacing and status-line bookkeeping */
+    int           key_buffer;
+    long          frames;
+    int           visible_frame;
+    int           ignore_delay;
+    long          frameskip;
+    unsigned long mymandelay;
+    unsigned long myman_sfx;
+    int           xoff_received;
+    int           showlives;
+    int           old_lines;
+    int           old_cols;
+    int           old_score;
+    int           old_showlives;
+    int           old_level;
+};
+
+/** Session used by the interactive game and the command-line tools */
+extern game_context_t game_main;
+
+/** Session the game code is currently operating on */
+extern _Thread_local game_context_t* game_ctx;
+
+extern game_context_t* game_context_clone(const game_context_t* from);
+extern void            game_context_free(game_context_t* ctx);
+
+#endif /* GAME_CONTEXT_H */
@@ -0,0 +1,122 @@
+/*
+ * game_context_aliases.h - Short names for the current session's state
+ *
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file game_context_aliases.h
+ * @brief Short names for the fields of the current game context
+ *
+ * Defines each game_context_t field name (`level`, `score`, `maze`,
+ * `sprite_register_x`, ...) as a macro for that field of game_ctx, so
+ * the older game modules can keep using the names as if they were
+ * globals. Because the macros capture any identifier of the same
+ * name, this header is private: include it only from a .c file that
+ * needs it, after globals.h, and never from another header. Code that
+ * does not include it names the fields through a context pointer
+ * (game_ctx->score, or ctx->score for a context it was handed).
+ *
+ * Several macros in utils.h (GHOSTS, DIRTY_ALL(), NET_LIVES, ...) are
+ * written in terms of these names, so they too are only usable where
+ * this header is included.
+ */
+
+#ifndef GAME_CONTEXT_ALIASES_H
+#define GAME_CONTEXT_ALIASES_H
+
+#include "game_context.h"
+
+#define level (game_ctx->level)
+#define intermission (game_ctx->intermission)
+#define intermission_shown (game_ctx->intermission_shown)
+#define cycles (game_ctx->cycles)
+#define score (game_ctx->score)
+#define dots (game_ctx->dots)
+#define points (game_ctx->points)
+#define lives_used (game_ctx->lives_used)
+#define earned (game_ctx->earned)
+#define dying (game_ctx->dying)
+#define dead (game_ctx->dead)
+#define deadpan (game_ctx->deadpan)
+#define oldplayer (game_ctx->oldplayer)
+#define player (game_ctx->player)
+#define pellet_timer (game_ctx->pellet_timer)
+#define pellet_time (game_ctx->pellet_time)
+#define myman_intro (game_ctx->myman_intro)
+#define myman_start (game_ctx->myman_start)
+#define myman_demo (game_ctx->myman_demo)
+#define myman_demo_setup (game_ctx->myman_demo_setup)
+#define munched (game_ctx->munched)
+#define winning (game_ctx->winning)
+#define ghost_eaten_timer (game_ctx->ghost_eaten_timer)
+#define paused (game_ctx->paused)
+#define intermission_running (game_ctx->intermission_running)
+#define need_reset (game_ctx->need_reset)
+
+#define sprite_register (game_ctx->sprite_register)
+#define sprite_register_frame (game_ctx->sprite_register_frame)
+#define sprite_register_x (game_ctx->sprite_register_x)
+#define sprite_register_y (game_ctx->sprite_register_y)
+#define sprite_register_used (game_ctx->sprite_register_used)
+#define sprite_register_timer (game_ctx->sprite_register_timer)
+#define sprite_register_color (game_ctx->sprite_register_color)
+#define ghost_dir (game_ctx->ghost_dir)
+#define ghost_mem (game_ctx->ghost_mem)
+#define ghost_man (game_ctx->ghost_man)
+#define ghost_timer (game_ctx->ghost_timer)
+#define hero_dir (game_ctx->hero_dir)
+#define pilot_rng (game_ctx->pilot_rng)
+
+#define maze (game_ctx->maze)
+#define maze_color (game_ctx->maze_color)
+#define maze_level (game_ctx->maze_level)
+#define dirty_cell (game_ctx->dirty_cell)
+#define all_dirty (game_ctx->all_dirty)
+#define status_dirty (game_ctx->status_dirty)
+#define row_run (game_ctx->row_run)
+#define col_run (game_ctx->col_run)
+#define zap_to (game_ctx->zap_to)
+#define home_dist (game_ctx->home_dist)
+#define route_level (game_ctx->route_level)
+#define maze_glyph (game_ctx->maze_glyph)
+#define pellet_cell (game_ctx->pellet_cell)
+#define glyph_level (game_ctx->glyph_level)
+#define sprite_cells (game_ctx->sprite_cells)
+
+#define key_buffer (game_ctx->key_buffer)
+#define frames (game_ctx->frames)
+#define visible_frame (game_ctx->visible_frame)
+#define ignore_delay (game_ctx->ignore_delay)
+#define frameskip (game_ctx->frameskip)
+#define mymandelay (game_ctx->mymandelay)
+#define myman_sfx (game_ctx->myman_sfx)
+#define xoff_received (game_ctx->xoff_received)
+#define showlives (game_ctx->showlives)
+#define old_lines (game_ctx->old_lines)
+#define old_cols (game_ctx->old_cols)
+#define old_score (game_ctx->old_score)
+#define old_showlives (game_ctx->old_showlives)
+#define old_level (game_ctx->old_level)
+#endif /* GAME_CONTEXT_ALIASES_H */
@@ -37,6 +37,9 @@
  * - Player state (player, oldplayer)
  * - Collectibles (dots, pellets, total_dots)
  *
+ * The per-game values (score, lives_used, level, dots, ...) are fields
+ * of game_context_t; see game_context.h.
+ *
  * @note Part of Phase 3 modularization - extracted from globals.h
  */
 
@@ -45,48 +48,15 @@
 
 #include <stdbool.h>
 
-extern int level;
-extern int intermission;
-extern int intermission_shown;
-extern int cycles;
-extern int score;
-extern int dots;
-extern int points;
+/** State of one game session; defined in game_context.h */
+typedef struct game_context game_context_t;
+
 extern int lives;
-extern int lives_used;
-extern int earned;
-extern int dying;
-extern int dead;
-extern int deadpan;
 extern int myman_lines;
 extern int myman_columns;
-extern int oldplayer;
-extern int player;
 
 extern bool nogame;
 
-extern long pellet_timer;
-extern long pellet_time;
-
-extern long          myman_intro;
-extern unsigned long myman_start;
-extern unsigned long myman_demo;
-extern int           munched;
-
-extern int  old_score;
-extern int  old_showlives;
-extern int  old_level;
-extern long winning;
-
-extern int ghost_eaten_timer;
-
-extern bool paused;
-
-extern long          intermission_running;
-extern unsigned long myman_demo_setup;
-
-extern int need_reset;
-
 extern int* total_dots;
 extern int* pellets;
 
@@ -95,17 +65,21 @@ extern long flip_to;
 extern int bonus_score[8];
 
 extern void gameintro(void);
+extern void gamepilot(void);
 extern void gamedemo(void);
 extern void gamestart(void);
 extern void gameintermission(void);
 extern void gamehelp(void);
 extern void gameinfo(void);
-extern int  gamelogic(void);
-extern void gamesfx(void);
+extern int  gamelogic(game_context_t* ctx);
+extern void gamesfx(game_context_t* ctx);
 extern void gamereset(void);
-extern void gamerender(void);
-extern int  gameinput(void);
-extern int  gamecycle(int lines, int cols);
+extern void gamerender(game_context_t* ctx);
+extern int  gameinput(game_context_t* ctx);
+extern void gameattract(game_context_t* ctx);
+extern int  gametick(game_context_t* ctx, int ret, int render);
+extern int  gamecycle(game_context_t* ctx, int lines, int cols);
+extern int  gamestep(game_context_t* ctx, int lines, int cols, int render);
 
 extern void creditscreen(void);
 
@@ -35,12 +35,17 @@
  * - maze_state.h: Maze data and dimensions
  * - render_state.h: Rendering and display state
  * - input_state.h: Input handling and timing
+ * - headless.h: Terminal-free simulation driver
+ * - replay.h: Input recording and replay
+ * - game_context.h: Per-session state (score, sprites, live maze, ...)
  *
  * @note Phase 3 modularization complete - globals.h now acts as
  *       a central aggregator for all module-specific headers
  *
  * Total global variables: 210+
- * Now organized into domain-specific modules for better maintainability
+ * Now organized into domain-specific modules for better maintainability;
+ * the state of a game in progress lives in game_context_t so several
+ * games can share one process
  */
 
 #ifndef GLOBALS_H
@@ -52,10 +57,16 @@
 #include <stdio.h>
 
 #include "game_state.h"
+#include "headless.h"
 #include "input_state.h"
 #include "maze_state.h"
 #include "render_state.h"
+#include "replay.h"
 #include "sprite_state.h"
+#include "vt.h"
+
+/* field aliases for the current session; keep this last */
+#include "game_context.h"
 
 /*============================================================================
  * CONSTANTS
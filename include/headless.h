@@ -0,0 +1,62 @@
+/*
+ * headless.h - Terminal-free simulation driver
+ *
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file headless.h
+ * @brief Terminal-free simulation driver
+ *
+ * Runs the game core (intro, attract-mode demo, gamelogic) without
+ * curses, input or frame pacing, as fast as the CPU allows. Used by the
+ * --headless command-line mode and by tools that embed the simulation.
+ */
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdio.h>
+
+#include "game_state.h"
+
+#ifndef HEADLESS_TICKS
+#define HEADLESS_TICKS 100000UL
+#endif
+
+/** Result of a headless run */
+typedef struct {
+    unsigned long ticks;   /**< ticks actually simulated */
+    double        seconds; /**< wall-clock time spent simulating */
+} headless_stats_t;
+
+extern int           headless;
+extern unsigned long headless_ticks;
+
+extern int  headless_tick(game_context_t* ctx);
+extern int  headless_run(game_context_t* ctx, unsigned long ticks,
+                         headless_stats_t* stats);
+extern void headless_report(FILE* stream, const headless_stats_t* stats);
+
+#endif /* HEADLESS_H */
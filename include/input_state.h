@@ -46,8 +46,8 @@
 #include <stdint.h>
 #include <stdio.h>
 
-extern int key_buffer;
 extern int key_buffer_ERR;
+extern int (*getch_hook)(void);
 
 extern const char*    MYMANKEYS_prefix;
 extern const char*    MOREMESSAGE;
@@ -57,6 +57,15 @@ extern const char*    MYMANKEYS;
 extern const char*    short_options;
 extern struct option* long_options;
 
+/* getopt_long() values for options that have no single-letter form */
+enum {
+    MYMAN_OPT_HEADLESS = 0x100,
+    MYMAN_OPT_TICKS,
+    MYMAN_OPT_RECORD,
+    MYMAN_OPT_REPLAY,
+    MYMAN_OPT_BACKEND
+};
+
 extern const char* progname;
 
 extern const unsigned long  uni_cp437_halfwidth[256];
@@ -30,7 +30,8 @@
  * @brief Maze data and state management
  *
  * Encapsulates all maze-related state including:
- * - Maze data arrays (maze, blank_maze, color data)
+ * - Maze data arrays (blank_maze, color data; the live maze is part of
+ *   game_context_t)
  * - Maze dimensions (width, height, levels)
  * - Maze metadata (flags, args)
  * - Maze loading and parsing
@@ -46,18 +47,13 @@
 #include <stddef.h>
 #include <stdint.h>
 
-extern char*    maze;
-extern char*    maze_color;
-extern char*    blank_maze;
-extern char*    blank_maze_color;
-extern uint8_t* dirty_cell;
-extern bool     all_dirty;
+extern char* blank_maze;
+extern char* blank_maze_color;
 
 extern int         maze_n;
 extern int         maze_w;
 extern int         maze_h;
 extern int         maze_flags;
-extern int         maze_level;
 extern const char* maze_args;
 
 extern const char* maze_ABOUT_prefix;
@@ -68,21 +64,36 @@ extern const char* maze_FIXME;
 extern const char* maze_NOTE;
 
 extern int readmaze(const char* mazefile, int* levels, int* w, int* h,
-                    char** maze, int* flags, char** color, const char** args);
+                    char** cells, int* flags, char** color, const char** args);
 
 extern void writemaze(const char* mazefile);
+extern int  writemaze_gmz(const char* gmzfile);
 extern int  parse_maze_args(const char* mazefile, const char* maze_args);
+extern void init_maze(void);
+extern int  maze_cache_load(const char* mazefile);
+extern void maze_cache_paint(void);
+extern void maze_routes(void);
+extern int  maze_zap_to(int x, int y);
 
 extern void maze_erase(void);
 extern void mark_cell(int x, int y);
+extern void mark_rect(int x0, int y0, int x1, int y1);
 extern void maze_puts(int y, int x, int color, const char* s);
 extern void maze_putsn_nonblank(int y, int x, int color, const char* s, int n);
+extern void maze_glyphs(void);
+extern void maze_glyph_cell(int x, int y);
 
 extern void paint_walls(int verbose);
+extern void paint_walls_on_demand(void);
+extern void paint_walls_then(void (*done)(void));
+extern void paint_walls_loaded(void);
+extern void maze_prepare(int n);
+extern int  maze_level_after(int n);
 
 extern uint16_t* inside_wall;
 
 extern long maze_visual(int n, int i, int j);
+extern long maze_visual_of(const char* cells, int n, int i, int j);
 
 extern const char* maze_WALL_COLORS;
 extern size_t      maze_WALL_COLORS_len;
@@ -79,42 +79,58 @@ extern uint8_t gfx2(uint8_t c);
 extern size_t  gfx1(const char** font, unsigned char c, int y, int x, int w);
 extern uint8_t gfx0(uint8_t c, uint8_t* m);
 
+extern uint8_t* tile_atlas;
+extern uint8_t* sprite_atlas;
+extern void     init_gfx_atlas(void);
+
 extern int reflect;
 extern int gfx_reflect;
 
 extern FILE*       snapshot;
 extern FILE*       snapshot_txt;
-extern int         xoff_received;
 extern double      td;
 extern const char* pager_notice;
 extern const char* pager_remaining;
 extern int         pager_arrow_magic;
 extern int         reinit_requested;
 
-extern int           old_lines;
-extern int           old_cols;
-extern int           ignore_delay;
-extern long          frameskip;
 extern long          frameskip0;
 extern long          frameskip1;
 extern long          scrolling;
-extern long          frames;
-extern unsigned long mymandelay;
 extern unsigned long mindelay;
 
 extern int use_underline;
 extern int use_color;
 
+/** Framebuffer of one curses screen, see render_state.c */
+typedef struct screen_fb screen_fb_t;
+
+/** Framebuffer of the current curses screen; switched with set_term() */
+extern screen_fb_t* screen_fb;
+
+extern screen_fb_t* screen_fb_new(void);
+extern void         screen_fb_free(screen_fb_t* f);
+
 extern int  my_clear(void);
 extern void my_clearok(int ok);
-
-extern int showlives;
-extern int visible_frame;
+extern void screen_fb_wipe(void);
+extern void screen_fb_forget(int y, int x, int n);
+extern int  screen_fb_put(int y, int x, unsigned long b, unsigned long attrs);
+extern int  screen_fb_erase(void);
+extern void screen_fb_sweep(void);
+extern int  screen_fb_frame(void);
+extern void screen_fb_status(int on);
+extern void screen_fb_status_sweep(void);
+extern void screen_fb_scroll(int top, int bot, int n);
+extern void myman_screen_init(void);
+extern void myman_screen_done(void);
+
+extern void          init_trans(int use_bullet_for_dots);
+extern unsigned long cells_rendered;
+extern unsigned long full_repaints;
 
 extern int debug;
 
-extern unsigned long myman_sfx;
-
 extern char* tmp_notice;
 
 extern const char* msg_READY;
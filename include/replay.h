@@ -0,0 +1,73 @@
+/*
+ * replay.h - Deterministic input recording and replay
+ *
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file replay.h
+ * @brief Deterministic input recording and replay
+ *
+ * --record FILE writes every key the game consumes, tagged with the
+ * frame counter, plus a hash of the simulation state every
+ * REPLAY_INTERVAL frames. --replay FILE feeds the keys back with no
+ * real-time pacing and checks each hash, so a replay is both a
+ * repeatable benchmark and a regression test for the game logic.
+ *
+ * The file is plain text, one event per line:
+ *   glomph-replay 1 INTERVAL FINGERPRINT   header (maze and options)
+ *   k FRAME KEY IGNORE_DELAY               key returned to the game
+ *   h FRAME HASH                           state checkpoint
+ *   e FRAME                                end of recording
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef REPLAY_INTERVAL
+#define REPLAY_INTERVAL 60L
+#endif
+
+extern const char* record_path;
+extern const char* replay_path;
+extern FILE*       record_stream;
+extern FILE*       replay_stream;
+
+extern int           replay_diverged;
+extern unsigned long replay_keys;
+extern unsigned long replay_checkpoints;
+
+extern uint64_t replay_fingerprint(void);
+extern uint64_t replay_hash(void);
+extern int      record_open(const char* path);
+extern void     record_close(void);
+extern int      replay_open(const char* path);
+extern void     replay_close(void);
+extern int      replay_input(int k);
+extern void     replay_checkpoint(void);
+
+#endif /* REPLAY_H */
@@ -36,6 +36,9 @@
  * - Hero movement (direction, position)
  * - Collision detection
  *
+ * The sprite registers, ghost AI arrays and hero_dir themselves are
+ * fields of game_context_t; see game_context.h.
+ *
  * @note Part of Phase 3 modularization - extracted from globals.h
  */
 
@@ -70,30 +73,15 @@ extern const char* sprite_NOTE;
 
 extern int parse_sprite_args(const char* spritefile, const char* sprite_args);
 
-extern int      ghost_dir[MAXGHOSTS];
-extern int      ghost_mem[MAXGHOSTS];
-extern int      ghost_man[MAXGHOSTS];
-extern int      ghost_timer[MAXGHOSTS];
-extern uint8_t* home_dir;
-
-extern uint8_t sprite_register[SPRITE_REGISTERS];
-extern int     sprite_register_frame[SPRITE_REGISTERS];
-extern int     sprite_register_x[SPRITE_REGISTERS];
-extern int     sprite_register_y[SPRITE_REGISTERS];
-extern int     sprite_register_used[SPRITE_REGISTERS];
-extern int     sprite_register_timer[SPRITE_REGISTERS];
-extern int     sprite_register_color[SPRITE_REGISTERS];
-
 extern void mark_sprite_register(int s);
 
 extern uint8_t reflect_sprite[256];
 extern uint8_t cp437_sprite[256];
 
 extern int dirhero;
-extern int hero_dir;
 
 extern int check_collision(int eyes, int mean, int blue);
-extern int find_home_dir(int s, int r, int c);
+extern int find_home_dir(int r, int c);
 
 extern int ghosts_p;
 
@@ -100,17 +100,28 @@ extern const char* DONEMESSAGE;
 #define ISTEXT(c)                                                              \
     (((c) == '!') || (((c) >= '0') && ((c) <= '9')) || ((c) == '@') ||         \
      (((c) >= 'A') && ((c) <= 'Z')))
-#define ISDOT(c) (((c) == 249) || ((c) == '.'))
-#define ISPELLET(c) (((c) == 254) || ((c) == 'o'))
-#define ISZAPLEFT(c) (((c) == '<') || (c == 174))
-#define ISZAPRIGHT(c) (((c) == '>') || (c == 175))
-#define ISZAPUP(c) ((c) == '^')
-#define ISZAPDOWN(c) ((c) == 'v')
-#define ISOPEN(c)                                                              \
-    (((c) == ' ') || ISDOT(c) || ISPELLET(c) || ((c) == '!') ||                \
-     (((c) >= 'A') && ((c) <= 'Z')) || ((c) == 'l') || ((c) == '~') ||         \
-     ISZAPRIGHT(c) || ISZAPLEFT(c) || ISZAPUP(c) || ISZAPDOWN(c))
-#define ISDOOR(c) (((c) == '=') || (c == ':') || ((c) == 240) || (c == 255))
+/* bits of maze_cell_class[]: what a maze character means to movement */
+#define CELL_OPEN 0x01
+#define CELL_DOOR 0x02
+#define CELL_DOT 0x04
+#define CELL_PELLET 0x08
+#define CELL_ZAPLEFT 0x10
+#define CELL_ZAPRIGHT 0x20
+#define CELL_ZAPUP 0x40
+#define CELL_ZAPDOWN 0x80
+#define CELL_ZAP (CELL_ZAPLEFT | CELL_ZAPRIGHT | CELL_ZAPUP | CELL_ZAPDOWN)
+/* home_dist of cells ghost eyes cannot reach the pen from */
+#define HOME_UNREACHED 0xffffU
+/* c is a maze character, 0 to 255, however it happens to be typed */
+#define CELL_CLASS(c) ((unsigned)maze_cell_class[(unsigned char)(c)])
+#define ISDOT(c) ((CELL_CLASS(c) & CELL_DOT) != 0)
+#define ISPELLET(c) ((CELL_CLASS(c) & CELL_PELLET) != 0)
+#define ISZAPLEFT(c) ((CELL_CLASS(c) & CELL_ZAPLEFT) != 0)
+#define ISZAPRIGHT(c) ((CELL_CLASS(c) & CELL_ZAPRIGHT) != 0)
+#define ISZAPUP(c) ((CELL_CLASS(c) & CELL_ZAPUP) != 0)
+#define ISZAPDOWN(c) ((CELL_CLASS(c) & CELL_ZAPDOWN) != 0)
+#define ISOPEN(c) ((CELL_CLASS(c) & CELL_OPEN) != 0)
+#define ISDOOR(c) ((CELL_CLASS(c) & CELL_DOOR) != 0)
 
 #define ISWALLCENTER(c)                                                        \
     ((((unsigned)(unsigned char)(char)(c)) == 0x07) ||                         \
@@ -133,8 +144,7 @@ extern const char* DONEMESSAGE;
     (ISWALLUP(c) || ISWALLDOWN(c) || ISWALLLEFT(c) || ISWALLRIGHT(c) ||        \
      ISWALLCENTER(c))
 #define ISNONINVERTABLE(c)                                                     \
-    (ISPELLET(c) || ISDOT(c) || ISZAPLEFT(c) || ISZAPRIGHT(c) || ISZAPUP(c) || \
-     ISZAPDOWN(c) || ISDOOR(c))
+    ((CELL_CLASS(c) & (CELL_DOT | CELL_PELLET | CELL_ZAP | CELL_DOOR)) != 0)
 
 #define NPENS 256
 
@@ -187,6 +197,10 @@ extern uint8_t cp437_sprite[256];
 
 extern const uint8_t udlr[256];
 
+/* movement class (CELL_* bits) of each maze character */
+
+extern const uint8_t maze_cell_class[256];
+
 /* fallback mapping for missing tiles */
 
 extern uint8_t fallback_cp437[256];
@@ -255,12 +269,19 @@ extern int parse_sprite_args(const char* spritefile, const char* sprite_args);
 extern const char* progname;
 
 extern int readmaze(const char* mazefile, int* levels, int* w, int* h,
-                    char** maze, int* flags, char** color, const char** args);
+                    char** cells, int* flags, char** color, const char** args);
 
 extern void writemaze(const char* mazefile);
+extern int  writemaze_gmz(const char* gmzfile);
 
 extern int parse_maze_args(const char* mazefile, const char* maze_args);
 
+extern void init_maze(void);
+extern int  maze_cache_load(const char* mazefile);
+extern void maze_cache_paint(void);
+extern void maze_routes(void);
+extern int  maze_zap_to(int x, int y);
+
 extern void parse_myman_args(int argc, char** argv);
 
 extern void usage(const char* mazefile, const char* spritefile,
@@ -300,12 +321,8 @@ extern char* mystrdup(const char* s);
 #define INTERMISSION_N 3
 #endif
 
-extern char*    maze;
-extern char*    maze_color;
 extern char*    blank_maze;
 extern char*    blank_maze_color;
-extern uint8_t* dirty_cell;
-extern bool     all_dirty;
 
 extern bool nogame;
 
@@ -313,7 +330,6 @@ extern int         maze_n;
 extern int         maze_w;
 extern int         maze_h;
 extern int         maze_flags;
-extern int         maze_level;
 extern const char* maze_args;
 
 extern int         tile_w;
@@ -366,10 +382,13 @@ extern int         sprite_color[256];
 
 #define XWRAP2(x) (XWRAP(x) % maze_w)
 
+/* 64-bit words per maze row of dirty_cell and pellet_cell */
+#define CELL_WORDS ((maze_w + 1 + 63) >> 6)
+
 #define CLEAN_ALL()                                                            \
     do {                                                                       \
         memset((void*)dirty_cell, 0,                                           \
-               maze_h * ((maze_w + 1 + 7) >> 3) * sizeof(*dirty_cell));        \
+               maze_h * CELL_WORDS * sizeof(*dirty_cell));                     \
         all_dirty = 0;                                                         \
     } while (0)
 #define DIRTY_ALL()                                                            \
@@ -380,17 +399,22 @@ extern int         sprite_color[256];
     (all_dirty ||                                                              \
      ((((long)(x)) >= 0) && (((long)(y)) >= 0) && ((x) <= maze_w) &&           \
       ((y) < maze_h) &&                                                        \
-      ((unsigned)dirty_cell[((y)) * ((maze_w + 1 + 7) >> 3) + ((x) >> 3)] &    \
-       (1 << ((x) & 7)))))
+      ((dirty_cell[(y) * CELL_WORDS + ((x) >> 6)] >> ((x) & 63)) & 1)))
 
 extern void maze_erase(void);
 
 extern void mark_cell(int x, int y);
 
+extern void mark_rect(int x0, int y0, int x1, int y1);
+
 extern void maze_puts(int y, int x, int color, const char* s);
 
 extern void maze_putsn_nonblank(int y, int x, int color, const char* s, int n);
 
+extern void maze_glyphs(void);
+
+extern void maze_glyph_cell(int x, int y);
+
 #ifndef LIVES
 #define LIVES 3
 #endif
@@ -403,10 +427,6 @@ extern void maze_putsn_nonblank(int y, int x, int color, const char* s, int n);
 #define MAXGHOSTS 16
 #endif
 
-extern int ghost_dir[MAXGHOSTS], ghost_mem[MAXGHOSTS], ghost_man[MAXGHOSTS],
-    ghost_timer[MAXGHOSTS];
-extern uint8_t* home_dir;
-
 /* sprite register numbers */
 #define GHOSTEYES(ghost) ((ghost) * 2)
 #define UNGHOSTEYES(sprite_register) ((sprite_register) / 2)
@@ -424,14 +444,6 @@ extern uint8_t* home_dir;
 /* total sprite register count */
 #define SPRITE_REGISTERS (BIGHERO_LR + 1)
 
-extern uint8_t sprite_register[SPRITE_REGISTERS];
-extern int     sprite_register_frame[SPRITE_REGISTERS];
-extern int     sprite_register_x[SPRITE_REGISTERS],
-    sprite_register_y[SPRITE_REGISTERS];
-extern int sprite_register_used[SPRITE_REGISTERS];
-extern int sprite_register_timer[SPRITE_REGISTERS];
-extern int sprite_register_color[SPRITE_REGISTERS];
-
 extern void mark_sprite_register(int s);
 
 #define SPRITE_FRUIT 0x00
@@ -484,21 +496,32 @@ extern uint8_t gfx0(uint8_t c, uint8_t* m);
 
 #define gfx_w (gfx_reflect ? tile_h : tile_w)
 #define gfx_h (gfx_reflect ? tile_w : tile_h)
+
+/* one pixel of a tile or sprite as drawn, from the atlases built by
+ * init_gfx_atlas(); each glyph is gfx_h rows of gfx_w bytes and the
+ * second half of each atlas holds the glyphs as drawn with reflect on */
 #define gfx(c, y, x)                                                           \
-    ((unsigned long)(unsigned char)gfx2((unsigned long)(unsigned char)gfx1(    \
-        tile,                                                                  \
-        (unsigned long)(unsigned char)gfx0(                                    \
-            ((unsigned long)(unsigned char)(c)), (reflect_cp437)),             \
-        (y) % gfx_h, (x) % gfx_w, tile_w)))
+    ((unsigned long)tile_atlas[(((reflect ? 256UL : 0UL) +                     \
+                                 (unsigned long)(unsigned char)(c)) *          \
+                                    gfx_h +                                    \
+                                (y) % gfx_h) *                                 \
+                                   gfx_w +                                     \
+                               (x) % gfx_w])
 
 #define sgfx_w (gfx_reflect ? sprite_h : sprite_w)
 #define sgfx_h (gfx_reflect ? sprite_w : sprite_h)
 #define sgfx(c, y, x)                                                          \
-    ((unsigned long)(unsigned char)gfx2((unsigned long)(unsigned char)gfx1(    \
-        sprite,                                                                \
-        (unsigned long)(unsigned char)gfx0(                                    \
-            ((unsigned long)(unsigned char)(c)), (reflect_sprite)),            \
-        (y) % sgfx_h, (x) % sgfx_w, sprite_w)))
+    ((unsigned long)sprite_atlas[(((reflect ? 256UL : 0UL) +                   \
+                                   (unsigned long)(unsigned char)(c)) *        \
+                                      sgfx_h +                                 \
+                                  (y) % sgfx_h) *                              \
+                                     sgfx_w +                                  \
+                                 (x) % sgfx_w])
+
+extern uint8_t* tile_atlas;
+extern uint8_t* sprite_atlas;
+
+extern void init_gfx_atlas(void);
 
 extern int reflect;
 extern int gfx_reflect;
@@ -557,54 +580,47 @@ extern int gfx_reflect;
 extern double doubletime(void);
 extern void   my_usleep(long usecs);
 
+typedef struct game_context game_context_t;
+
 extern void gameintro(void);
+extern void gamepilot(void);
 extern void gamedemo(void);
 extern void gamestart(void);
 extern void gameintermission(void);
 extern void gamehelp(void);
 extern void gameinfo(void);
-extern int  gamelogic(void);
-extern void gamesfx(void);
+extern int  gamelogic(game_context_t* ctx);
+extern void gamesfx(game_context_t* ctx);
 extern void gamereset(void);
-extern void gamerender(void);
-extern int  gameinput(void);
-extern int  gamecycle(int lines, int cols);
+extern void gamerender(game_context_t* ctx);
+extern int  gameinput(game_context_t* ctx);
+extern void gameattract(game_context_t* ctx);
+extern int  gametick(game_context_t* ctx, int ret, int render);
+extern int  gamecycle(game_context_t* ctx, int lines, int cols);
+extern int  gamestep(game_context_t* ctx, int lines, int cols, int render);
 
 extern void creditscreen(void);
 extern void paint_walls(int verbose);
+extern void paint_walls_on_demand(void);
+extern void paint_walls_then(void (*done)(void));
+extern void paint_walls_loaded(void);
+extern void maze_prepare(int n);
+extern int  maze_level_after(int n);
 
 extern uint16_t*     inside_wall;
 extern FILE*         snapshot;
 extern FILE*         snapshot_txt;
-extern int           xoff_received;
 extern double        td;
 extern const char*   pager_notice;
 extern const char*   pager_remaining;
 extern int           pager_arrow_magic;
 extern int           reinit_requested;
-extern long          myman_intro;
-extern unsigned long myman_start;
-extern unsigned long myman_demo;
-extern int           munched;
-extern int           old_lines, old_cols, old_score, old_showlives, old_level;
-extern int           ignore_delay;
-extern long          frameskip, frameskip0, frameskip1;
+extern long          frameskip0, frameskip1;
 extern long          scrolling;
-extern long          frames;
-extern long          winning;
-extern unsigned long mymandelay;
 extern unsigned long mindelay;
-extern int           ghost_eaten_timer;
-extern bool          paused;
-extern long          intermission_running;
-extern unsigned long myman_demo_setup;
-extern int           need_reset;
-extern int level, intermission, intermission_shown, cycles, score, dots, points,
-    lives, lives_used, earned, dying, dead, deadpan, myman_lines, myman_columns,
-    oldplayer, player;
-extern int  key_buffer;
+extern int lives, myman_lines, myman_columns;
 extern int  key_buffer_ERR;
-extern long pellet_timer, pellet_time;
+extern int (*getch_hook)(void);
 
 #define GHOST0 ((ghosts > 2) ? 0 : 2)
 #define GHOST1 1
@@ -777,18 +793,6 @@ extern long pellet_timer, pellet_time;
 
 #define ghosts ((GHOSTS > MAXGHOSTS) ? MAXGHOSTS : GHOSTS)
 
-#define WHOSE_HOME_DIR(r, c)                                                   \
-    (((unsigned)                                                               \
-          home_dir[(GHOST2 % ghosts * maze_h + (r)) * (maze_w + 1) + (c)])     \
-         ? GHOST2                                                              \
-     : ((unsigned)                                                             \
-            home_dir[(GHOST0 % ghosts * maze_h + (r)) * (maze_w + 1) + (c)])   \
-         ? GHOST0                                                              \
-     : ((unsigned)                                                             \
-            home_dir[(GHOST3 % ghosts * maze_h + (r)) * (maze_w + 1) + (c)])   \
-         ? GHOST3                                                              \
-         : GHOST1)
-
 #define rmsg (RMSG % maze_h)
 #define cmsg (CMSG % maze_w)
 #define rmsg2 (RMSG2 % maze_h)
@@ -983,15 +987,11 @@ extern int           dirhero;
 extern long          scroll_offset_x0;
 extern long          scroll_offset_y0;
 extern int           msglen;
-extern int           hero_dir;
 extern int*          total_dots;
 extern int*          pellets;
 extern long          flip_to;
 extern int           debug;
 extern int           ghosts_p;
-extern unsigned long myman_sfx;
-extern int           showlives;
-extern int           visible_frame;
 
 #define myman_sfx_credit 0x1UL
 #define myman_sfx_dot 0x2UL
@@ -1089,6 +1089,21 @@ extern int           visible_frame;
 
 extern int  my_clear(void);
 extern void my_clearok(int ok);
+extern void screen_fb_wipe(void);
+extern void screen_fb_forget(int y, int x, int n);
+extern int  screen_fb_put(int y, int x, unsigned long b, unsigned long attrs);
+extern int  screen_fb_erase(void);
+extern void screen_fb_sweep(void);
+extern int  screen_fb_frame(void);
+extern void screen_fb_status(int on);
+extern void screen_fb_status_sweep(void);
+extern void screen_fb_scroll(int top, int bot, int n);
+extern void myman_screen_init(void);
+extern void myman_screen_done(void);
+
+extern void          init_trans(int use_bullet_for_dots);
+extern unsigned long cells_rendered;
+extern unsigned long full_repaints;
 
 #ifndef BONUSHERO
 #define BONUSHERO 10000
@@ -1127,10 +1142,11 @@ extern int bonus_score[8];
 
 extern int check_collision(int eyes, int mean, int blue);
 
-extern int find_home_dir(int s, int r, int c);
+extern int find_home_dir(int r, int c);
 
 /* heuristic for rewriting maze tiles */
 extern long maze_visual(int n, int i, int j);
+extern long maze_visual_of(const char* cells, int n, int i, int j);
 
 extern int myman_setenv(const char* name, const char* value);
 
@@ -0,0 +1,62 @@
+/*
+ * vt.h - Direct VT/ANSI terminal output
+ *
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file vt.h
+ * @brief Direct VT/ANSI output backend
+ *
+ * With --backend=vt, gamerender() frames bypass curses output. Each
+ * cell that differs from the framebuffer in render_state.c is appended
+ * to one buffer as cursor motion, SGR attributes and a precomputed
+ * UTF-8 glyph, and the whole frame goes to the terminal in a single
+ * write(). Curses still owns the terminal modes, input, the pager and
+ * snapshots; my_refresh() repaints through curses when it next runs.
+ *
+ * The terminal is assumed to understand ANSI cursor and SGR sequences
+ * and UTF-8 (except in raw CP437 mode, which sends the bytes as-is).
+ */
+
+#ifndef VT_H
+#define VT_H
+
+#include <stdio.h>
+
+extern int vt_backend;
+extern int vt_active;
+extern int vt_stale;
+
+extern void vt_output(FILE* stream);
+extern void vt_begin(void);
+extern void vt_clear(void);
+extern void vt_move(int y, int x);
+extern void vt_getyx(int* y, int* x);
+extern int  vt_addch(unsigned long b, unsigned long attrs);
+extern void vt_put(int y, int x, unsigned long b, unsigned long attrs);
+extern void vt_scroll(int top, int bot, int n);
+extern int  vt_flush(void);
+
+#endif /* VT_H */
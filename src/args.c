@@ -31,6 +31,7 @@
 
 #include "globals.h"
 #include "utils.h"
+#include "game_context_aliases.h"
 
 /* Build configuration - MYMANSIZE and file paths are set by CMake per variant
  */
@@ -246,96 +247,138 @@ void parse_myman_args(int argc, char** argv) {
     unsigned long uli;
 
     while ((i = getopt_long(argc, argv, short_options, long_options,
-                            &option_index)) != -1)
+                            &option_index)) != -1) {
         /* Delegate to helper functions for simple option categories */
         handle_info_options(i, mazefile, spritefile, tilefile);
-    handle_display_options(i);
-    handle_audio_options(i);
-    handle_file_options(i, &mazefile, &spritefile, &tilefile);
-    handle_dump_options(i, &dump_maze, &dump_sprite, &dump_tile);
-
-    /* Handle complex options that need validation or local state */
-    switch (i) {
-    case 'v':
-        defvariant = optarg;
-        break;
-    case 'z':
-        defsize = optarg;
-        break;
-    case 'd': {
-        char garbage;
-
-        if (sscanf(optarg, "%lu%c", &uli, &garbage) != 1) {
-            fprintf(stderr,
+        handle_display_options(i);
+        handle_audio_options(i);
+        handle_file_options(i, &mazefile, &spritefile, &tilefile);
+        handle_dump_options(i, &dump_maze, &dump_sprite, &dump_tile);
+
+        /* Handle complex options that need validation or local state */
+        switch (i) {
+        case 'v':
+            defvariant = optarg;
+            break;
+        case 'z':
+            defsize = optarg;
+            break;
+        case 'd': {
+            char garbage;
+
+            if (sscanf(optarg, "%lu%c", &uli, &garbage) != 1) {
+                fprintf(
+                    stderr,
                     "%s: argument to -d must be an unsigned long integer.\n",
                     progname);
-            fflush(stderr), exit(1);
-        }
-        mymandelay = uli;
-        mindelay   = mymandelay / 2;
-        break;
-    }
-    case 'D': {
-        char*       name;
-        const char* value;
-
-        value = "1";
-        name  = strdup(optarg);
-        if (!name) {
-            perror("strdup");
-            fflush(stderr), exit(1);
-        }
-        if (strchr(name, '=')) {
-            *(strchr(name, '=')) = '\0';
-            value                = name + strlen(name) + 1;
+                fflush(stderr), exit(1);
+            }
+            mymandelay = uli;
+            mindelay   = mymandelay / 2;
+            break;
         }
-        if (myman_setenv(name, value)) {
-            perror("setenv");
-            fflush(stderr), exit(1);
+        case 'D': {
+            char*       name;
+            const char* value;
+
+            value = "1";
+            name  = strdup(optarg);
+            if (!name) {
+                perror("strdup");
+                fflush(stderr), exit(1);
+            }
+            if (strchr(name, '=')) {
+                *(strchr(name, '=')) = '\0';
+                value                = name + strlen(name) + 1;
+            }
+            if (myman_setenv(name, value)) {
+                perror("setenv");
+                fflush(stderr), exit(1);
+            }
+            {
+                const char* check_value;
+
+                check_value = myman_getenv(name);
+                if (check_value ? strcmp(check_value, value) : *value) {
+                    fprintf(stderr,
+                            "setenv: did not preserve value, %s=%s vs %s=%s\n",
+                            name, value, name,
+                            check_value ? check_value : "(null)");
+                    fflush(stderr), exit(1);
+                }
+            }
+            free((void*)name);
+            break;
         }
-        {
-            const char* check_value;
+        case 'g': {
+            const char* tmp_ghosts_endp = NULL;
 
-            check_value = myman_getenv(name);
-            if (check_value ? strcmp(check_value, value) : *value) {
-                fprintf(
-                    stderr, "setenv: did not preserve value, %s=%s vs %s=%s\n",
-                    name, value, name, check_value ? check_value : "(null)");
+            maze_GHOSTS =
+                strtollist(optarg, &tmp_ghosts_endp, &maze_GHOSTS_len);
+            if (!maze_GHOSTS) {
+                perror("-g");
+                fflush(stderr), exit(1);
+            } else if (tmp_ghosts_endp && *tmp_ghosts_endp) {
+                fprintf(stderr, "%s: -g: garbage after argument: %s\n",
+                        progname, tmp_ghosts_endp);
                 fflush(stderr), exit(1);
             }
+            ghosts_p = 1;
+            break;
         }
-        free((void*)name);
-        break;
-    }
-    case 'g': {
-        const char* tmp_ghosts_endp = NULL;
+        case 'l': {
+            char garbage;
 
-        maze_GHOSTS = strtollist(optarg, &tmp_ghosts_endp, &maze_GHOSTS_len);
-        if (!maze_GHOSTS) {
-            perror("-g");
-            fflush(stderr), exit(1);
-        } else if (tmp_ghosts_endp && *tmp_ghosts_endp) {
-            fprintf(stderr, "%s: -g: garbage after argument: %s\n", progname,
-                    tmp_ghosts_endp);
-            fflush(stderr), exit(1);
+            if (sscanf(optarg, "%lu%c", &uli, &garbage) != 1) {
+                fprintf(stderr,
+                        "%s: argument to -l must be an unsigned integer.\n",
+                        progname);
+                fflush(stderr), exit(1);
+            }
+            lives = (int)uli;
+            break;
         }
-        ghosts_p = 1;
-        break;
-    }
-    case 'l': {
-        char garbage;
+        case MYMAN_OPT_HEADLESS:
+            headless = 1;
+            break;
+        case MYMAN_OPT_TICKS: {
+            char garbage;
 
-        if (sscanf(optarg, "%lu%c", &uli, &garbage) != 1) {
-            fprintf(stderr, "%s: argument to -l must be an unsigned integer.\n",
+            if (sscanf(optarg, "%lu%c", &uli, &garbage) != 1) {
+                fprintf(
+                    stderr,
+                    "%s: argument to --ticks must be an unsigned integer.\n",
                     progname);
-            fflush(stderr), exit(1);
+                fflush(stderr), exit(1);
+            }
+            headless_ticks = uli;
+            break;
+        }
+        case MYMAN_OPT_RECORD:
+            record_path = optarg;
+            break;
+        case MYMAN_OPT_REPLAY:
+            replay_path = optarg;
+            break;
+        case MYMAN_OPT_BACKEND:
+            if (!strcmp(optarg, "vt")) {
+                vt_backend = 1;
+            } else if (!strcmp(optarg, "curses")) {
+                vt_backend = 0;
+            } else {
+                fprintf(stderr,
+                        "%s: argument to --backend must be curses or vt.\n",
+                        progname);
+                fflush(stderr), exit(1);
+            }
+            break;
+        case '?':
+            fprintf(stderr, SUMMARY(progname));
+            fflush(stderr), exit(2);
+        default:
+            /* already handled by one of the helpers above */
+            break;
         }
-        lives = (int)uli;
-        break;
-    }
-    default:
-        fprintf(stderr, SUMMARY(progname));
-        fflush(stderr), exit(2);
     }
 
     if (myman_getenv("MYMAN_DEBUG") && *(myman_getenv("MYMAN_DEBUG")) &&
@@ -378,6 +421,7 @@ void parse_myman_args(int argc, char** argv) {
         }
 
     gfx_reflect = reflect && !REFLECT_LARGE;
+    init_gfx_atlas();
 
 #if !MYMANDELAY
     if (mymandelay) {
@@ -409,8 +453,9 @@ void parse_myman_args(int argc, char** argv) {
                maze_n * maze_h * (maze_w + 1));
     }
 #endif /* defined(BUILTIN_MAZE) */
-    if (mazefile && readmaze(mazefile, &maze_n, &maze_w, &maze_h, &maze,
-                             &maze_flags, &maze_color, &maze_args)) {
+    if (mazefile && (!maze_cache_load(mazefile)) &&
+        readmaze(mazefile, &maze_n, &maze_w, &maze_h, &maze, &maze_flags,
+                 &maze_color, &maze_args)) {
         exit(1);
     }
     if (maze_args)
@@ -419,67 +464,11 @@ void parse_myman_args(int argc, char** argv) {
             exit(1);
         }
 
-    msglen     = MAX(MAX(strlen(msg_PLAYER1), strlen(msg_PLAYER2)),
-                     MAX(strlen(msg_READY), strlen(msg_GAMEOVER)));
-    total_dots = (int*)malloc(maze_n * sizeof(*total_dots));
-    if (!total_dots) {
-        perror("malloc");
-        exit(1);
-    }
-    memset((void*)total_dots, 0, maze_n * sizeof(*total_dots));
-    pellets = (int*)malloc(maze_n * sizeof(*pellets));
-    if (!pellets) {
-        perror("malloc");
-        exit(1);
-    }
-    memset((void*)pellets, 0, maze_n * sizeof(*pellets));
-    blank_maze =
-        (char*)malloc(maze_n * maze_h * (maze_w + 1) * sizeof(*blank_maze));
-    if (!blank_maze) {
-        perror("malloc");
-        exit(1);
-    }
-    memset((void*)blank_maze, 0,
-           maze_n * maze_h * (maze_w + 1) * sizeof(*blank_maze));
-    blank_maze_color = (char*)malloc(maze_n * maze_h * (maze_w + 1) *
-                                     sizeof(*blank_maze_color));
-    if (!blank_maze_color) {
-        perror("malloc");
-        exit(1);
-    }
-    memset((void*)blank_maze_color, 0,
-           maze_n * maze_h * (maze_w + 1) * sizeof(*blank_maze_color));
-    inside_wall = (unsigned short*)malloc(maze_n * maze_h * (maze_w + 1) *
-                                          sizeof(*inside_wall));
-    if (!inside_wall) {
-        perror("malloc");
-        exit(1);
-    }
-    memset((void*)inside_wall, 0,
-           maze_n * maze_h * (maze_w + 1) * sizeof(*inside_wall));
-    dirty_cell = (unsigned char*)malloc(maze_h * ((maze_w + 1 + 7) >> 3) *
-                                        sizeof(*dirty_cell));
-    if (!dirty_cell) {
-        perror("malloc");
-        exit(1);
-    }
-    memset((void*)dirty_cell, 0,
-           maze_h * ((maze_w + 1 + 7) >> 3) * sizeof(*dirty_cell));
-    home_dir = (unsigned char*)malloc(MAXGHOSTS * maze_h * (maze_w + 1) *
-                                      sizeof(*home_dir));
-    if (!home_dir) {
-        perror("malloc");
-        exit(1);
-    }
-    memset((void*)home_dir, 0,
-           MAXGHOSTS * maze_h * (maze_w + 1) * sizeof(*home_dir));
-    memcpy((void*)blank_maze, (void*)maze,
-           (maze_w + 1) * maze_h * maze_n * sizeof(unsigned char));
-    memcpy((void*)blank_maze_color, (void*)maze_color,
-           (maze_w + 1) * maze_h * maze_n * sizeof(unsigned char));
-
-    CLEAN_ALL();
-    paint_walls(isatty(fileno(stderr)));
+    init_maze();
+    /* only the first level is painted before the first frame, unless
+     * the maze cache has them all; the rest follow in the background */
+    maze_cache_paint();
+    maze_prepare(maze_level);
     gamereset();
 
     if (dump_maze)
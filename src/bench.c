@@ -0,0 +1,341 @@
+/* bench.c - Per-maze throughput benchmark for Glomph Maze
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * glomph-bench loads every maze through readmaze(), paint_walls() and a
+ * fixed number of scripted (attract mode) game ticks rendered into an
+ * off-screen curses screen, once per tile/sprite size, and writes one
+ * CSV row per maze and size to stdout.
+ *
+ * Each game's state lives in its game_context_t, but the maze, the
+ * fonts and the tables derived from them are global, so each
+ * measurement runs in its own forked child: every maze and size starts
+ * from a pristine process and a maze that crashes the loader is
+ * reported instead of taking the whole run down.
+ */
+
+#include <curses.h>
+#include <dirent.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "globals.h"
+#include "utils.h"
+
+#ifndef BENCH_TICKS
+#define BENCH_TICKS 200UL
+#endif
+
+#ifndef BENCH_MAZEDIR
+#define BENCH_MAZEDIR MAZEDIR
+#endif
+
+/* "name:tilefile:spritefile" entries separated by spaces; CMake passes
+ * the same tile/sprite pairs it uses for the size variants */
+#ifndef BENCH_SIZES
+#define BENCH_SIZES "standard:" TILEDIR "/chr4.txt:" SPRITEDIR "/spr8.txt"
+#endif
+
+typedef struct {
+    const char* name;
+    const char* tilefile;
+    const char* spritefile;
+} bench_size_t;
+
+static bench_size_t* sizes   = NULL;
+static size_t        n_sizes = 0;
+
+static void bench_usage(void) {
+    printf("Usage: %s [-n TICKS] [-z SIZE] [MAZE...]\n", progname);
+    printf("-n NUM \tsimulate and render NUM ticks per maze (default %lu)\n",
+           (unsigned long)BENCH_TICKS);
+    puts("-z SIZE \tonly measure tile/sprite size SIZE");
+    puts("-h \tdisplay this help and exit");
+    printf("Sizes:");
+    {
+        size_t i;
+
+        for (i = 0; i < n_sizes; i++) {
+            printf(" %s", sizes[i].name);
+        }
+    }
+    printf("\nWithout MAZE arguments every file in %s/ is measured.\n",
+           BENCH_MAZEDIR);
+}
+
+/* split BENCH_SIZES into the sizes[] table */
+static void parse_sizes(void) {
+    char* spec;
+    char* entry;
+
+    spec = strdup(BENCH_SIZES);
+    if (!spec) {
+        perror("strdup");
+        exit(1);
+    }
+    for (entry = strtok(spec, " "); entry; entry = strtok(NULL, " ")) {
+        char*         tiles;
+        char*         sprites;
+        bench_size_t* tmp;
+
+        tiles = strchr(entry, ':');
+        if (!tiles || !(sprites = strchr(tiles + 1, ':'))) {
+            fprintf(stderr, "%s: bad size specification `%s'\n", progname,
+                    entry);
+            exit(1);
+        }
+        *tiles++   = '\0';
+        *sprites++ = '\0';
+        tmp        = (bench_size_t*)realloc((void*)sizes,
+                                            (n_sizes + 1) * sizeof(*sizes));
+        if (!tmp) {
+            perror("realloc");
+            exit(1);
+        }
+        sizes                     = tmp;
+        sizes[n_sizes].name       = entry;
+        sizes[n_sizes].tilefile   = tiles;
+        sizes[n_sizes].spritefile = sprites;
+        n_sizes++;
+    }
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+/* collect the regular files in dir, sorted by name */
+static char** list_mazes(const char* dir, size_t* n) {
+    DIR*           d;
+    struct dirent* ent;
+    char**         names = NULL;
+
+    *n = 0;
+    d  = opendir(dir);
+    if (!d) {
+        perror(dir);
+        exit(1);
+    }
+    while ((ent = readdir(d)) != NULL) {
+        char** tmp;
+        char*  path;
+
+        if (ent->d_name[0] == '.')
+            continue;
+        path = (char*)malloc(strlen(dir) + 1 + strlen(ent->d_name) + 1);
+        tmp  = (char**)realloc((void*)names, (*n + 1) * sizeof(*names));
+        if (!path || !tmp) {
+            perror("malloc");
+            exit(1);
+        }
+        sprintf(path, "%s/%s", dir, ent->d_name);
+        names     = tmp;
+        names[*n] = path;
+        *n += 1;
+    }
+    closedir(d);
+    qsort((void*)names, *n, sizeof(*names), compare_names);
+    return names;
+}
+
+/**
+ * @brief Measure one maze at one tile/sprite size
+ *
+ * Runs in a forked child. Loads the fonts, then times readmaze() plus
+ * parse_maze_args(), paint_walls(), and @p ticks attract-mode ticks
+ * (gameattract() + gametick()) rendered into a curses screen whose
+ * output goes to /dev/null.
+ *
+ * @return 0 on success, 1 if the maze or fonts could not be loaded
+ */
+static int bench_one(const char* mazefile, const bench_size_t* size,
+                     unsigned long ticks) {
+    double        t0, t_parse, t_paint, t_ticks;
+    unsigned long n;
+    FILE*         devnull;
+    SCREEN*       screen;
+    const char*   term;
+    char          buf[32];
+
+    if (readfont(size->tilefile, &tile_w, &tile_h, tile, tile_used,
+                 &tile_flags, tile_color, &tile_args) ||
+        readfont(size->spritefile, &sprite_w, &sprite_h, sprite, sprite_used,
+                 &sprite_flags, sprite_color, &sprite_args))
+        return 1;
+    if (tile_args && parse_tile_args(size->tilefile, tile_args))
+        return 1;
+    if (sprite_args && parse_sprite_args(size->spritefile, sprite_args))
+        return 1;
+    gfx_reflect = reflect && !REFLECT_LARGE;
+    init_gfx_atlas();
+
+    t0 = doubletime();
+    if (readmaze(mazefile, &maze_n, &maze_w, &maze_h, &game_ctx->maze,
+                 &maze_flags, &game_ctx->maze_color, &maze_args))
+        return 1;
+    if (maze_args && parse_maze_args(mazefile, maze_args))
+        return 1;
+    t_parse = doubletime() - t0;
+
+    init_maze();
+    t0 = doubletime();
+    paint_walls(0);
+    t_paint = doubletime() - t0;
+    gamereset();
+
+    /* size the virtual terminal so the whole maze is on screen */
+    sprintf(buf, "%d", maze_h * gfx_h + 3 * tile_h + sprite_h);
+    myman_setenv("LINES", buf);
+    sprintf(buf, "%d", maze_w * gfx_w);
+    myman_setenv("COLUMNS", buf);
+    devnull = fopen("/dev/null", "w");
+    if (!devnull) {
+        perror("/dev/null");
+        return 1;
+    }
+    term = myman_getenv("TERM");
+    screen =
+        newterm((char*)((term && *term) ? term : "vt100"), devnull, stdin);
+    if (!screen)
+        screen = newterm((char*)"vt100", devnull, stdin);
+    if (!screen) {
+        fprintf(stderr, "%s: newterm failed\n", progname);
+        return 1;
+    }
+    set_term(screen);
+    leaveok(stdscr, TRUE);
+    init_trans(use_bullet_for_dots);
+
+    cells_rendered = 0;
+    t0             = doubletime();
+    for (n = 0; n < ticks; n++) {
+        gameattract(&game_main);
+        gametick(&game_main, -1, 1);
+        game_ctx->myman_sfx = 0UL;
+    }
+    t_ticks = doubletime() - t0;
+    endwin();
+    delscreen(screen);
+    fclose(devnull);
+
+    printf("%s,%s,%d,%d,%d,%.3f,%.3f,%lu,%.0f,%lu,%.0f\n", mazefile,
+           size->name, maze_n, maze_w, maze_h, t_parse * 1e3, t_paint * 1e3,
+           ticks, (t_ticks > 0.0) ? (ticks / t_ticks) : 0.0, cells_rendered,
+           (t_ticks > 0.0) ? (cells_rendered / t_ticks) : 0.0);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long ticks     = BENCH_TICKS;
+    const char*   only_size = NULL;
+    char**        mazes;
+    size_t        n_mazes;
+    size_t        i, j;
+    int           failures = 0;
+    int           opt;
+
+    progname = (argc > 0) ? argv[0] : "glomph-bench";
+    parse_sizes();
+    while ((opt = getopt(argc, argv, "n:z:h")) != -1) {
+        switch (opt) {
+        case 'n': {
+            char garbage;
+
+            if (sscanf(optarg, "%lu%c", &ticks, &garbage) != 1) {
+                fprintf(stderr,
+                        "%s: argument to -n must be an unsigned integer.\n",
+                        progname);
+                return 1;
+            }
+            break;
+        }
+        case 'z':
+            only_size = optarg;
+            break;
+        case 'h':
+            bench_usage();
+            return 0;
+        default:
+            fprintf(stderr, "Usage: %s [-n TICKS] [-z SIZE] [MAZE...]\n",
+                    progname);
+            return 2;
+        }
+    }
+    if (optind < argc) {
+        mazes   = argv + optind;
+        n_mazes = (size_t)(argc - optind);
+    } else {
+        mazes = list_mazes(BENCH_MAZEDIR, &n_mazes);
+    }
+
+    for (i = 0; i < SPRITE_REGISTERS; i++) {
+        game_ctx->sprite_register_used[i]  = 0;
+        game_ctx->sprite_register_frame[i] = 0;
+        game_ctx->sprite_register_color[i] = 0x7;
+    }
+    for (i = 0; i < 256; i++) {
+        tile_color[i]   = 0x7;
+        sprite_color[i] = 0x7;
+    }
+
+    printf("maze,size,levels,width,height,parse_ms,paint_ms,ticks,"
+           "ticks_per_sec,cells,cells_per_sec\n");
+    for (j = 0; j < n_sizes; j++) {
+        if (only_size && strcmp(only_size, sizes[j].name))
+            continue;
+        for (i = 0; i < n_mazes; i++) {
+            pid_t pid;
+            int   status;
+
+            fflush(stdout);
+            fflush(stderr);
+            pid = fork();
+            if (pid < 0) {
+                perror("fork");
+                return 1;
+            }
+            if (!pid) {
+                status = bench_one(mazes[i], sizes + j, ticks);
+                fflush(stdout);
+                _exit(status);
+            }
+            if ((waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) ||
+                WEXITSTATUS(status)) {
+                fprintf(stderr, "%s: %s (%s): failed\n", progname, mazes[i],
+                        sizes[j].name);
+                failures++;
+            }
+        }
+    }
+    if (failures) {
+        fprintf(stderr, "%s: %d measurement(s) failed\n", progname, failures);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+/* game_context.c - Per-session game state for Glomph Maze
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+#include <curses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "globals.h"
+#include "utils.h"
+
+game_context_t game_main = {.myman_intro = 1,
+                            .munched     = HERO,
+                            .winning     = 1,
+                            .player      = 1,
+                            .key_buffer  = ERR,
+                            .mymandelay  = MYMANDELAY};
+
+_Thread_local game_context_t* game_ctx = &game_main;
+
+/* duplicate one of the per-session buffers, exiting if out of memory */
+static void* clone_buffer(const void* from, size_t len) {
+    void* to;
+
+    if (!from)
+        return NULL;
+    to = malloc(len);
+    if (!to) {
+        perror("malloc");
+        exit(1);
+    }
+    memcpy(to, from, len);
+    return to;
+}
+
+/**
+ * @brief Start a new session from a copy of an existing one
+ *
+ * Copies every field of @p from, giving the new session its own live
+ * maze, ghost home trails and dirty-cell bitmap. Cloning game_main
+ * right after the maze has been loaded and gamereset() has run yields
+ * a session that plays exactly like a freshly started game.
+ *
+ * @param from Session to copy (normally &game_main)
+ * @return New session; release it with game_context_free()
+ * @note Exits on allocation failure
+ */
+game_context_t* game_context_clone(const game_context_t* from) {
+    game_context_t* ctx;
+    size_t          cells = (size_t)maze_n * maze_h * (maze_w + 1);
+
+    ctx = (game_context_t*)malloc(sizeof(*ctx));
+    if (!ctx) {
+        perror("malloc");
+        exit(1);
+    }
+    *ctx              = *from;
+    ctx->maze         = (char*)clone_buffer(from->maze, cells);
+    ctx->maze_color   = (char*)clone_buffer(from->maze_color, cells);
+    ctx->dirty_cell   = (uint64_t*)clone_buffer(
+        from->dirty_cell, (size_t)maze_h * CELL_WORDS * sizeof(uint64_t));
+    ctx->row_run      = (uint16_t*)clone_buffer(
+        from->row_run, (size_t)maze_h * (maze_w + 1) * sizeof(uint16_t));
+    ctx->col_run      = (uint16_t*)clone_buffer(
+        from->col_run, (size_t)maze_h * (maze_w + 1) * sizeof(uint16_t));
+    ctx->zap_to       = (uint16_t*)clone_buffer(
+        from->zap_to, (size_t)maze_h * (maze_w + 1) * sizeof(uint16_t));
+    ctx->home_dist    = (uint16_t*)clone_buffer(
+        from->home_dist, (size_t)maze_h * (maze_w + 1) * sizeof(uint16_t));
+    ctx->maze_glyph   = (uint16_t*)clone_buffer(
+        from->maze_glyph, (size_t)maze_h * (maze_w + 1) * sizeof(uint16_t));
+    ctx->pellet_cell  = (uint64_t*)clone_buffer(
+        from->pellet_cell, (size_t)maze_h * CELL_WORDS * sizeof(uint64_t));
+    ctx->sprite_cells = (uint64_t*)clone_buffer(
+        from->sprite_cells, (size_t)maze_h * (maze_w + 1) * sizeof(uint64_t));
+    return ctx;
+}
+
+/**
+ * @brief Release a session created by game_context_clone()
+ */
+void game_context_free(game_context_t* ctx) {
+    if (!ctx)
+        return;
+    if (game_ctx == ctx)
+        game_ctx = &game_main;
+    free((void*)ctx->maze);
+    free((void*)ctx->maze_color);
+    free((void*)ctx->dirty_cell);
+    free((void*)ctx->row_run);
+    free((void*)ctx->col_run);
+    free((void*)ctx->zap_to);
+    free((void*)ctx->home_dist);
+    free((void*)ctx->maze_glyph);
+    free((void*)ctx->pellet_cell);
+    free((void*)ctx->sprite_cells);
+    free((void*)ctx);
+}
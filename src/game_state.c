@@ -29,6 +29,7 @@
 
 #include "globals.h"
 #include "utils.h"
+#include "game_context_aliases.h"
 
 /**
  * @brief Display maze/tile/sprite metadata information
@@ -246,6 +247,7 @@ void gamestart(void) {
     intermission       = 0;
     intermission_shown = 0;
     maze_erase();
+    maze_prepare(maze_level);
     ghost_eaten_timer = 0;
     winning           = 1;
     oldplayer         = 0;
@@ -370,19 +372,19 @@ void creditscreen(void) {
 }
 
 /**
- * @brief Run attract mode demo gameplay
+ * @brief Steer the hero the way the attract-mode demo does
  *
- * Automated demo mode showing gameplay when no one is playing. Initializes
- * game state, sets up automatic navigation for hero, and runs simplified
- * game logic without score tracking. Hero follows walls autonomously using
- * home_dir pathfinding.
+ * Every few frames, looks at the four cells around the hero and turns
+ * towards a pellet, then a dot, then any open cell that does not
+ * reverse direction. Used by gamedemo() and by glomph-sim, which plays
+ * whole games with it.
  *
- * @note Sets myman_demo flag and player = 1 (no scoring)
- * @note Cycles through levels automatically for variety
- * @see gamestart, find_home_dir
+ * When the current context has a nonzero pilot_rng, about one decision
+ * in four instead picks a random open, non-reversing direction, so
+ * games started from different seeds play out differently. With
+ * pilot_rng == 0 (the default) the pilot is fully scripted.
  */
-void gamedemo(void) {
-    int s;
+void gamepilot(void) {
     int xtile, ytile;
     int x_off, y_off;
 
@@ -390,52 +392,6 @@ void gamedemo(void) {
     ytile = YTILE(sprite_register_y[HERO]);
     x_off = sprite_register_x[HERO] % gfx_w;
     y_off = sprite_register_y[HERO] % gfx_h;
-    if ((myman_demo == 1) && (!myman_demo_setup)) {
-        level              = 0;
-        maze_level         = 0;
-        intermission       = 0;
-        intermission_shown = 0;
-        for (s = 0; s < SPRITE_REGISTERS; s++) {
-            sprite_register_used[s]  = 0;
-            sprite_register_timer[s] = 0;
-            sprite_register_frame[s] = 0;
-        }
-        maze_erase();
-        ghost_eaten_timer = 0;
-        winning           = 1;
-        oldplayer         = 0;
-        player            = 1;
-        pellet_timer      = 0;
-        pellet_time       = PELLET_ADJUST(7 * ONESEC);
-        for (s = 0; s < frames % 8; s++) {
-            pellet_time -= PELLET_ADJUST(7 * ONESEC);
-            if (level && (FLIP_ALWAYS || INTERMISSION(level))) {
-                ++maze_level;
-                maze_level %= maze_n;
-                if (!maze_level) {
-                    maze_level = flip_to % maze_n;
-                }
-                if (FLIP_LOCK && !maze_level) {
-                    maze_level = maze_n - 1;
-                }
-            }
-            ++level;
-            sprite_register_frame[FRUIT] = sprite_register_frame[FRUIT_SCORE] =
-                BONUS(level);
-            pellet_time += PELLET_ADJUST(7 * ONESEC);
-            if (pellet_time > PELLET_ADJUST(ONESEC))
-                pellet_time -= PELLET_ADJUST(ONESEC);
-            else
-                pellet_time = 0;
-        }
-        cycles  = 0;
-        dots    = 0;
-        dead    = 0;
-        deadpan = 0;
-        dying   = 0;
-        myman_demo_setup =
-            1 + (15UL * (maze_h * maze_w) * TWOSECS / (28 * 31)) / 2;
-    }
     if (!(winning || dying || (dead && !ghost_eaten_timer))) {
         if (!(frames % ((TWOSECS / 20) + 1))) {
             unsigned char mleft, mdown, mright, mup;
@@ -453,6 +409,36 @@ void gamedemo(void) {
                 maze[(maze_level * maze_h + YWRAP(ytile - NOTBOTTOM(y_off))) *
                          (maze_w + 1) +
                      xtile];
+            if (pilot_rng) {
+                static const int turn[4] = {MYMAN_LEFT, MYMAN_DOWN,
+                                            MYMAN_RIGHT, MYMAN_UP};
+                static const int back[4] = {MYMAN_RIGHT, MYMAN_UP,
+                                            MYMAN_LEFT, MYMAN_DOWN};
+                static const int face[4] = {4, 16, 12, 0};
+                unsigned char    m[4];
+                int              ways[4];
+                int              n_open = 0;
+                int              i;
+
+                /* xorshift32: one step per decision, so a seed replays */
+                pilot_rng ^= pilot_rng << 13;
+                pilot_rng ^= pilot_rng >> 17;
+                pilot_rng ^= pilot_rng << 5;
+                m[0] = mleft;
+                m[1] = mdown;
+                m[2] = mright;
+                m[3] = mup;
+                for (i = 0; i < 4; i++) {
+                    if (ISOPEN((unsigned)m[i]) && (hero_dir != back[i]))
+                        ways[n_open++] = i;
+                }
+                if (n_open && !(pilot_rng & 3)) {
+                    i                     = ways[(pilot_rng >> 2) % n_open];
+                    hero_dir              = turn[i];
+                    sprite_register[HERO] = SPRITE_HERO + face[i];
+                    return;
+                }
+            }
             if (ISOPEN((unsigned)mleft) && ISPELLET((unsigned)mleft)) {
                 hero_dir              = MYMAN_LEFT;
                 sprite_register[HERO] = SPRITE_HERO + 4;
@@ -508,6 +494,64 @@ void gamedemo(void) {
             }
         }
     }
+}
+
+/**
+ * @brief Run attract mode demo gameplay
+ *
+ * Automated demo mode showing gameplay when no one is playing. Initializes
+ * game state, sets up automatic navigation for hero, and runs simplified
+ * game logic without score tracking. Hero is steered by gamepilot().
+ *
+ * @note Sets myman_demo flag and player = 1 (no scoring)
+ * @note Cycles through levels automatically for variety
+ * @see gamestart, gamepilot
+ */
+void gamedemo(void) {
+    int s;
+
+    if ((myman_demo == 1) && (!myman_demo_setup)) {
+        level              = 0;
+        maze_level         = 0;
+        intermission       = 0;
+        intermission_shown = 0;
+        for (s = 0; s < SPRITE_REGISTERS; s++) {
+            sprite_register_used[s]  = 0;
+            sprite_register_timer[s] = 0;
+            sprite_register_frame[s] = 0;
+        }
+        maze_erase();
+        maze_prepare(maze_level);
+        ghost_eaten_timer = 0;
+        winning           = 1;
+        oldplayer         = 0;
+        player            = 1;
+        pellet_timer      = 0;
+        pellet_time       = PELLET_ADJUST(7 * ONESEC);
+        for (s = 0; s < frames % 8; s++) {
+            pellet_time -= PELLET_ADJUST(7 * ONESEC);
+            if (level && (FLIP_ALWAYS || INTERMISSION(level))) {
+                maze_level = maze_level_after(maze_level);
+            }
+            maze_prepare(maze_level);
+            ++level;
+            sprite_register_frame[FRUIT] = sprite_register_frame[FRUIT_SCORE] =
+                BONUS(level);
+            pellet_time += PELLET_ADJUST(7 * ONESEC);
+            if (pellet_time > PELLET_ADJUST(ONESEC))
+                pellet_time -= PELLET_ADJUST(ONESEC);
+            else
+                pellet_time = 0;
+        }
+        cycles  = 0;
+        dots    = 0;
+        dead    = 0;
+        deadpan = 0;
+        dying   = 0;
+        myman_demo_setup =
+            1 + (15UL * (maze_h * maze_w) * TWOSECS / (28 * 31)) / 2;
+    }
+    gamepilot();
     if (myman_demo_setup) {
         myman_demo_setup--;
     }
@@ -1017,53 +1061,54 @@ int check_collision(int eyes, int mean, int blue) {
 }
 
 /**
- * @brief Find pathfinding direction for ghost at given position
+ * @brief Which way is the ghost pen from a maze cell?
  *
- * Looks up pre-computed pathfinding direction from home_dir array.
- * Used by ghost AI to navigate maze efficiently toward targets.
- * Each ghost has its own pathfinding map stored in home_dir.
+ * Follows the distance field maze_routes() builds from the pen
+ * (home_dist): returns the direction of the neighbouring cell that is
+ * fewest steps from home, preferring up, left, down, right on ties.
+ * Doors count as open, since ghost eyes pass through them.
  *
- * @param s Ghost index (0-15, see MAXGHOSTS)
  * @param r Row position in maze (tile coordinates)
  * @param c Column position in maze (tile coordinates)
  *
- * @return Direction constant (MYMAN_UP, MYMAN_DOWN, MYMAN_LEFT, MYMAN_RIGHT)
- *
- * @note Requires home_dir array to be initialized
- * @see WHOSE_HOME_DIR macro, ghost AI in gamelogic
+ * @return Direction constant (MYMAN_UP, MYMAN_DOWN, MYMAN_LEFT,
+ *         MYMAN_RIGHT), or 0 in the pen itself and where the pen cannot
+ *         be reached
+ * @see maze_routes, ghost AI in gamelogic
  */
-int find_home_dir(int s, int r, int c) {
-    return (
-        ((unsigned)home_dir[(WHOSE_HOME_DIR((r), (c)) % ghosts * maze_h + (r)) *
-                                (maze_w + 1) +
-                            (c)])
-            ? ((unsigned)
-                   home_dir[(WHOSE_HOME_DIR((r), (c)) % ghosts * maze_h + (r)) *
-                                (maze_w + 1) +
-                            (c)])
-            : ((unsigned)home_dir[((s)*maze_h + (r)) * (maze_w + 1) + (c)]));
+int find_home_dir(int r, int c) {
+    int      d, way = 0;
+    unsigned best;
+
+    maze_routes();
+    best = home_dist[r * (maze_w + 1) + c];
+    for (d = MYMAN_UP; d <= MYMAN_RIGHT; d++) {
+        unsigned n = home_dist[YWRAP(r + YDIR(d)) * (maze_w + 1) +
+                               XWRAP(c + XDIR(d))];
+
+        if (n < best) {
+            best = n;
+            way  = d;
+        }
+    }
+    return way;
 }
-int gamecycle(int lines, int cols) {
+
+/**
+ * @brief Drop back into attract mode once the current game is over
+ *
+ * When no lives remain and nothing is still animating (death, ghost
+ * score, intermission, pending reset), clears the sprite registers and
+ * restarts the intro sequence from level 0.
+ *
+ * @param ctx Session to update; becomes the current context
+ * @see gamecycle, gametick
+ */
+void gameattract(game_context_t* ctx) {
     int s;
-    int ret;
 
-    showlives = ((myman_intro || myman_start || myman_demo) ? 0 : NET_LIVES) -
-                1 +
-                (((munched == HERO) && (!sprite_register_used[HERO])) ? 1 : 0);
-    if ((old_lines != lines) || (old_cols != cols) || (old_score > score) ||
-        (old_showlives != showlives) || (old_level != level)) {
-        DIRTY_ALL();
-        ignore_delay = 1;
-        frameskip    = 0;
-        old_lines    = lines;
-        old_cols     = cols;
-        /* TODO: make some video memory for the status areas
-         * in order to avoid unnecessary full refreshes */
-        old_score     = score;
-        old_showlives = showlives;
-        old_level     = level;
-    }
-    gamesfx();
+    game_ctx = ctx;
+
     if (!(winning || NET_LIVES || dead || dying || ghost_eaten_timer ||
           myman_intro || myman_demo || myman_start || intermission_running ||
           need_reset)) {
@@ -1086,6 +1131,7 @@ int gamecycle(int lines, int cols) {
             sprite_register_frame[s] = 0;
         }
         maze_erase();
+        maze_prepare(maze_level);
         oldplayer    = 0;
         player       = 1;
         pellet_timer = 0;
@@ -1096,108 +1142,31 @@ int gamecycle(int lines, int cols) {
         deadpan      = 0;
         dying        = 0;
     }
-#if MYMANDELAY
-    if (mymandelay && (!myman_demo_setup) &&
-        !((frames + frameskip) % (frameskip ? frameskip : 1))) {
-        double        td2;
-        unsigned long actual_delay;
+}
 
-        do {
-            actual_delay =
-                (myman_demo ? ((mymandelay + mindelay) / 2) : mymandelay) *
-                (frameskip ? frameskip : 1);
-            td2 = doubletime();
-            if (td == -1.0L) {
-                td        = 0.0L;
-                td2       = 0.0L;
-                frameskip = 0;
-            }
-            if (td == 0.0L) {
-                td = td2 - (actual_delay * 1e-6L);
-            }
-            if ((td2 != 0.0L) && (td != 0.0L)) {
-                if (td2 > td) {
-                    unsigned long delta;
-                    double        nframeskip;
-                    size_t        kfr;
-                    int           use_buffer;
-                    static double onframeskip[] = {0.0, 0.0, 0.0, 0.0, 0.0,
-                                                   0.0, 0.0, 0.0, 0.0, 0.0};
+/**
+ * @brief Advance the game by one tick
+ *
+ * Runs everything in a frame that happens after input has been read:
+ * intro, attract-mode demo, credit countdown, intermission, gamelogic(),
+ * the power pellet timer and (optionally) gamerender(). Does no pacing
+ * and reads no keys, so it can be driven without a terminal.
+ *
+ * @param ctx    Session to advance; becomes the current context
+ * @param ret    Input result from gameinput(): -1 if no key was pressed,
+ *               -2 if a key was consumed
+ * @param render Nonzero to call gamerender() on visible frames
+ *
+ * @return 1 to keep running
+ * @see gamecycle, headless_tick
+ */
+int gametick(game_context_t* ctx, int ret, int render) {
+    int s;
 
-                    nframeskip = onframeskip[0];
-                    for (kfr = 1;
-                         kfr < sizeof(onframeskip) / sizeof(*onframeskip);
-                         kfr++) {
-                        nframeskip += onframeskip[kfr];
-                        onframeskip[kfr - 1] = onframeskip[kfr];
-                    }
-                    nframeskip /= kfr;
-                    use_buffer = (frameskip == (nframeskip + 0.5));
-                    delta      = (unsigned long int)(1e6L * (td2 - td));
-                    nframeskip = ((frameskip ? frameskip : 1) * delta) /
-                                 (actual_delay ? actual_delay : 1);
-                    if (nframeskip > MAXFRAMESKIP) {
-                        nframeskip = MAXFRAMESKIP;
-                    }
-                    onframeskip[kfr - 1] = nframeskip;
-                    if (use_buffer)
-                        nframeskip = 0.0;
-                    for (kfr = 0;
-                         kfr < sizeof(onframeskip) / sizeof(*onframeskip);
-                         kfr++) {
-                        if (use_buffer)
-                            nframeskip += onframeskip[kfr];
-                        else
-                            onframeskip[kfr] = nframeskip;
-                    }
-                    if (use_buffer)
-                        nframeskip /= kfr;
-                    if (!ignore_delay) {
-                        frameskip = (unsigned long)(nframeskip + 0.5);
-                    }
-                    actual_delay = (myman_demo ? ((mymandelay + mindelay) / 2)
-                                               : mymandelay) *
-                                   (frameskip ? frameskip : 1);
-                    if (delta <= actual_delay) {
-                        actual_delay -= delta;
-                    } else {
-                        actual_delay = 0;
-                    }
-                }
-            }
-            if (actual_delay) {
-                unsigned long secs;
+    game_ctx = ctx;
 
-                secs = actual_delay / 999999L;
-                while (secs--) {
-                    my_usleep(999999UL);
-                    actual_delay -= 999999UL;
-                }
-                if (actual_delay % 999999UL) {
-                    my_usleep(actual_delay % 999999UL);
-                }
-                if (actual_delay ==
-                    ((myman_demo ? ((mymandelay + mindelay) / 2) : mymandelay) *
-                     (frameskip ? frameskip : 1))) {
-                    break;
-                }
-            } else {
-                break;
-            }
-        } while (1);
-        ignore_delay = 0;
-        td           = doubletime();
-        if (td == -1.0L) {
-            ignore_delay = 1;
-            frameskip    = 0;
-        }
-    }
-#endif
-    ret = gameinput();
-    if (ret >= 0) {
-        return ret;
-    }
     visible_frame = !((frames++) % (frameskip ? frameskip : 1));
+    replay_checkpoint();
     if (myman_intro && !(paused || snapshot || snapshot_txt)) {
         gameintro();
         if (((!ghost_eaten_timer) &&
@@ -1243,6 +1212,7 @@ int gamecycle(int lines, int cols) {
                 sprite_register_frame[s] = 0;
             }
             maze_erase();
+            maze_prepare(maze_level);
             if (myman_start) {
                 creditscreen();
                 ret        = -1;
@@ -1270,12 +1240,12 @@ int gamecycle(int lines, int cols) {
     }
     if (!(paused || snapshot || snapshot_txt || myman_intro || myman_start ||
           intermission_running)) {
-        if (gamelogic()) {
+        if (gamelogic(ctx)) {
             return 1;
         }
     }
-    if (visible_frame && !(xoff_received || myman_demo_setup)) {
-        gamerender();
+    if (render && visible_frame && !(xoff_received || myman_demo_setup)) {
+        gamerender(ctx);
     }
     if (!(paused || snapshot || snapshot_txt)) {
         if (pellet_timer && (!ghost_eaten_timer)) {
@@ -1305,3 +1275,185 @@ int gamecycle(int lines, int cols) {
     }
     return 1;
 }
+
+/* force a full redraw when the terminal size changed, and have the
+ * status area cleaned up when the score, lives or level changed */
+static void gamestatus(int lines, int cols) {
+    showlives = ((myman_intro || myman_start || myman_demo) ? 0 : NET_LIVES) -
+                1 +
+                (((munched == HERO) && (!sprite_register_used[HERO])) ? 1 : 0);
+    if ((old_lines != lines) || (old_cols != cols)) {
+        DIRTY_ALL();
+        ignore_delay = 1;
+        frameskip    = 0;
+        old_lines    = lines;
+        old_cols     = cols;
+    }
+    if ((old_score > score) || (old_showlives != showlives) ||
+        (old_level != level)) {
+        status_dirty  = 1;
+        ignore_delay  = 1;
+        frameskip     = 0;
+        old_score     = score;
+        old_showlives = showlives;
+        old_level     = level;
+    }
+}
+
+/**
+ * @brief Run one interactive frame: status bookkeeping, pacing, input
+ *
+ * Forces a full redraw when the terminal size changed and a status area
+ * cleanup when it changed, plays pending sound effects, sleeps to hold
+ * the configured frame rate, reads a key and then advances the game
+ * with gametick().
+ *
+ * @param ctx   Session to run; becomes the current context
+ * @param lines Current terminal height
+ * @param cols  Current terminal width
+ *
+ * @return 0 to quit, nonzero to keep running
+ * @see gametick, gameinput
+ */
+int gamecycle(game_context_t* ctx, int lines, int cols) {
+    int ret;
+
+    game_ctx = ctx;
+
+    gamestatus(lines, cols);
+    gamesfx(ctx);
+    gameattract(ctx);
+#if MYMANDELAY
+    if (mymandelay && (!myman_demo_setup) &&
+        !((frames + frameskip) % (frameskip ? frameskip : 1))) {
+        double        td2;
+        unsigned long actual_delay;
+
+        do {
+            actual_delay =
+                (myman_demo ? ((mymandelay + mindelay) / 2) : mymandelay) *
+                (frameskip ? frameskip : 1);
+            td2 = doubletime();
+            if (td == -1.0L) {
+                td        = 0.0L;
+                td2       = 0.0L;
+                frameskip = 0;
+            }
+            if (td == 0.0L) {
+                td = td2 - (actual_delay * 1e-6L);
+            }
+            if ((td2 != 0.0L) && (td != 0.0L)) {
+                if (td2 > td) {
+                    unsigned long delta;
+                    double        nframeskip;
+                    size_t        kfr;
+                    int           use_buffer;
+                    static double onframeskip[] = {0.0, 0.0, 0.0, 0.0, 0.0,
+                                                   0.0, 0.0, 0.0, 0.0, 0.0};
+
+                    nframeskip = onframeskip[0];
+                    for (kfr = 1;
+                         kfr < sizeof(onframeskip) / sizeof(*onframeskip);
+                         kfr++) {
+                        nframeskip += onframeskip[kfr];
+                        onframeskip[kfr - 1] = onframeskip[kfr];
+                    }
+                    nframeskip /= kfr;
+                    use_buffer = (frameskip == (nframeskip + 0.5));
+                    delta      = (unsigned long int)(1e6L * (td2 - td));
+                    nframeskip = ((frameskip ? frameskip : 1) * delta) /
+                                 (actual_delay ? actual_delay : 1);
+                    if (nframeskip > MAXFRAMESKIP) {
+                        nframeskip = MAXFRAMESKIP;
+                    }
+                    onframeskip[kfr - 1] = nframeskip;
+                    if (use_buffer)
+                        nframeskip = 0.0;
+                    for (kfr = 0;
+                         kfr < sizeof(onframeskip) / sizeof(*onframeskip);
+                         kfr++) {
+                        if (use_buffer)
+                            nframeskip += onframeskip[kfr];
+                        else
+                            onframeskip[kfr] = nframeskip;
+                    }
+                    if (use_buffer)
+                        nframeskip /= kfr;
+                    if (!ignore_delay) {
+                        frameskip = (unsigned long)(nframeskip + 0.5);
+                    }
+                    actual_delay = (myman_demo ? ((mymandelay + mindelay) / 2)
+                                               : mymandelay) *
+                                   (frameskip ? frameskip : 1);
+                    if (delta <= actual_delay) {
+                        actual_delay -= delta;
+                    } else {
+                        actual_delay = 0;
+                    }
+                }
+            }
+            if (actual_delay) {
+                unsigned long secs;
+
+                secs = actual_delay / 999999L;
+                while (secs--) {
+                    my_usleep(999999UL);
+                    actual_delay -= 999999UL;
+                }
+                if (actual_delay % 999999UL) {
+                    my_usleep(actual_delay % 999999UL);
+                }
+                if (actual_delay ==
+                    ((myman_demo ? ((mymandelay + mindelay) / 2) : mymandelay) *
+                     (frameskip ? frameskip : 1))) {
+                    break;
+                }
+            } else {
+                break;
+            }
+        } while (1);
+        ignore_delay = 0;
+        td           = doubletime();
+        if (td == -1.0L) {
+            ignore_delay = 1;
+            frameskip    = 0;
+        }
+    }
+#endif
+    ret = gameinput(ctx);
+    if (ret >= 0) {
+        return ret;
+    }
+    return gametick(ctx, ret, 1);
+}
+
+/**
+ * @brief Run one frame whose pacing is the caller's job
+ *
+ * Same as gamecycle() without the sleep: for drivers that schedule many
+ * sessions from one event loop. The delay a redraw would have absorbed
+ * is considered served, so keys are buffered normally.
+ *
+ * @param ctx    Session to run; becomes the current context
+ * @param lines  Current terminal height
+ * @param cols   Current terminal width
+ * @param render Nonzero to draw the frame, zero to only simulate it
+ *
+ * @return 0 to quit, nonzero to keep running
+ * @see gamecycle
+ */
+int gamestep(game_context_t* ctx, int lines, int cols, int render) {
+    int ret;
+
+    game_ctx = ctx;
+
+    gamestatus(lines, cols);
+    gamesfx(ctx);
+    gameattract(ctx);
+    ignore_delay = 0;
+    ret          = gameinput(ctx);
+    if (ret >= 0) {
+        return ret;
+    }
+    return gametick(ctx, ret, render);
+}
@@ -0,0 +1,114 @@
+/* gmz.c - Maze compiler for Glomph Maze
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * glomph-gmz compiles maze files into the binary .gmz format (see
+ * writemaze_gmz()), which readmaze() maps instead of parsing. Any of
+ * the programs loads a .gmz maze given with -m, or listed among the
+ * mazes of glomph-bench and glomph-sim, just like the text it came
+ * from.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "globals.h"
+#include "utils.h"
+
+static void gmz_usage(void) {
+    printf("Usage: %s [-d DIR] MAZE...\n", progname);
+    puts("-d DIR \twrite DIR/NAME.gmz for each MAZE named NAME (default .)");
+    puts("-h \tdisplay this help and exit");
+}
+
+/**
+ * @brief Compile one maze
+ *
+ * Loads @p mazefile with readmaze(), checks that parse_maze_args()
+ * accepts its arguments, and writes it with writemaze_gmz() to
+ * @p dir/NAME.gmz, NAME being the last component of @p mazefile. The
+ * extension is kept, since mazes/foo.asc and mazes/foo.txt differ.
+ *
+ * @return 0 on success, 1 on error
+ */
+static int gmz_one(const char* mazefile, const char* dir) {
+    const char* name;
+    char*       gmzfile;
+    int         ret;
+
+    if (readmaze(mazefile, &maze_n, &maze_w, &maze_h, &game_ctx->maze,
+                 &maze_flags, &game_ctx->maze_color, &maze_args))
+        return 1;
+    if (maze_args && parse_maze_args(mazefile, maze_args))
+        return 1;
+    name    = strrchr(mazefile, '/');
+    name    = name ? (name + 1) : mazefile;
+    gmzfile = (char*)malloc(strlen(dir) + 1 + strlen(name) + 5);
+    if (!gmzfile) {
+        perror("malloc");
+        exit(1);
+    }
+    sprintf(gmzfile, "%s/%s.gmz", dir, name);
+    ret = writemaze_gmz(gmzfile);
+    free((void*)gmzfile);
+    return ret;
+}
+
+int main(int argc, char* argv[]) {
+    const char* dir      = ".";
+    int         failures = 0;
+    int         opt;
+
+    progname = (argc > 0) ? argv[0] : "glomph-gmz";
+    while ((opt = getopt(argc, argv, "d:h")) != -1) {
+        switch (opt) {
+        case 'd':
+            dir = optarg;
+            break;
+        case 'h':
+            gmz_usage();
+            return 0;
+        default:
+            fprintf(stderr, "Usage: %s [-d DIR] MAZE...\n", progname);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Usage: %s [-d DIR] MAZE...\n", progname);
+        return 2;
+    }
+    for (; optind < argc; optind++) {
+        if (gmz_one(argv[optind], dir)) {
+            fprintf(stderr, "%s: %s: failed\n", progname, argv[optind]);
+            failures++;
+        }
+    }
+    if (failures) {
+        fprintf(stderr, "%s: %d maze(s) failed\n", progname, failures);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+/* headless.c - Terminal-free simulation driver for Glomph Maze
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+
+#include "globals.h"
+#include "utils.h"
+#include "game_context_aliases.h"
+
+int           headless       = 0;
+unsigned long headless_ticks = HEADLESS_TICKS;
+
+/**
+ * @brief Advance the simulation by one tick without a terminal
+ *
+ * Equivalent to gamecycle() with no key pressed, except that nothing is
+ * rendered, no sound is played and no time is spent sleeping. With no
+ * input the game stays in attract mode, so the hero is steered by the
+ * gamedemo() autopilot and gamelogic() runs for every demo frame.
+ *
+ * @param ctx Session to advance
+ *
+ * @return 1 to keep running (gametick() never asks to stop)
+ * @see gametick, gameattract
+ */
+int headless_tick(game_context_t* ctx) {
+    int ret;
+
+    gameattract(ctx);
+    ret = gametick(ctx, -1, 0);
+    /* nobody is listening; don't let requests pile up */
+    myman_sfx = 0UL;
+    return ret;
+}
+
+/**
+ * @brief Run the simulation for a fixed number of ticks
+ *
+ * Library-style entry point: expects the maze, tiles and sprites to be
+ * loaded already (parse_myman_args() does this) and never touches
+ * curses.
+ *
+ * @param ctx   Session to run (normally &game_main)
+ * @param ticks Number of ticks to simulate
+ * @param stats Receives the tick count and elapsed time (may be NULL)
+ *
+ * @return 0 on success, 1 if the simulation asked to stop early
+ * @see headless_tick, headless_report
+ */
+int headless_run(game_context_t* ctx, unsigned long ticks,
+                 headless_stats_t* stats) {
+    unsigned long n;
+    double        t0;
+    int           ret = 0;
+
+    t0 = doubletime();
+    for (n = 0; n < ticks; n++) {
+        if (!headless_tick(ctx)) {
+            ret = 1;
+            break;
+        }
+    }
+    if (stats) {
+        stats->ticks   = n;
+        stats->seconds = doubletime() - t0;
+    }
+    return ret;
+}
+
+/**
+ * @brief Print the throughput of a headless run
+ *
+ * @param stream Where to write the report (normally stderr)
+ * @param stats  Result of headless_run()
+ */
+void headless_report(FILE* stream, const headless_stats_t* stats) {
+    fprintf(stream, "%s: %lu ticks in %.3f s (%.0f ticks/s)\n", progname,
+            stats->ticks, stats->seconds,
+            (stats->seconds > 0.0) ? (stats->ticks / stats->seconds) : 0.0);
+}
@@ -51,6 +51,7 @@
 #endif
 
 #include "globals.h"
+#include "game_context_aliases.h"
 
 /* command-line argument parser */
 #ifndef MYGETOPT_H
@@ -69,6 +70,195 @@
 #define HUGE_VAL 1e500
 #endif
 
+/* where a zap cell at (x, y) of the current level sends the hero: the
+ * nearest paired zap cell in its direction of travel, wrapping around
+ * the maze edge, or the cell itself if there is none */
+static int find_zap_exit(const char* cells, int x, int y) {
+    unsigned c = (unsigned)(unsigned char)cells[y * (maze_w + 1) + x];
+    int      ii;
+
+    if (ISZAPLEFT(c) || ISZAPRIGHT(c)) {
+        int step = ISZAPLEFT(c) ? -1 : 1;
+
+        for (ii = 1; ii < maze_w; ii++) {
+            c = (unsigned)(unsigned char)
+                cells[y * (maze_w + 1) + XWRAP(x + step * ii)];
+            if ((step < 0) ? ISZAPRIGHT(c) : ISZAPLEFT(c))
+                break;
+        }
+        return XWRAP(x + step * ii);
+    } else {
+        int step = ISZAPUP(c) ? -1 : 1;
+
+        for (ii = 1; ii < maze_h; ii++) {
+            c = (unsigned)(unsigned char)
+                cells[YWRAP(y + step * ii) * (maze_w + 1) + x];
+            if ((step < 0) ? ISZAPDOWN(c) : ISZAPUP(c))
+                break;
+        }
+        return YWRAP(y + step * ii);
+    }
+}
+
+/* can ghost eyes pass through maze character c? */
+#define EYES_PASS(c)                                                           \
+    (CELL_CLASS((unsigned)(unsigned char)(c)) & (CELL_OPEN | CELL_DOOR))
+
+/* breadth-first search outwards from the ghost pen (the cells around
+ * XGHOST, YGHOST) filling in home_dist, moving the way ghost eyes can:
+ * through open cells and doors, wrapping around the maze edges */
+static void find_home_dist(const char* cells) {
+    size_t n = (size_t)maze_h * (maze_w + 1);
+    int*   queue;
+    size_t head = 0, tail = 0;
+    size_t k;
+    int    r, c, d;
+
+    queue = (int*)malloc(n * sizeof(*queue));
+    if (!queue) {
+        perror("malloc");
+        exit(1);
+    }
+    for (k = 0; k < n; k++)
+        home_dist[k] = HOME_UNREACHED;
+    for (r = YTILE((int)YGHOST - 1); r <= YTILE((int)YGHOST); r++) {
+        for (c = XTILE((int)XGHOST - 1); c <= XTILE((int)XGHOST); c++) {
+            k = (size_t)YWRAP(r) * (maze_w + 1) + XWRAP(c);
+            if (EYES_PASS(cells[k]) && (home_dist[k] == HOME_UNREACHED)) {
+                home_dist[k]  = 0;
+                queue[tail++] = (int)k;
+            }
+        }
+    }
+    while (head < tail) {
+        k = (size_t)queue[head++];
+        r = (int)(k / (maze_w + 1));
+        c = (int)(k % (maze_w + 1));
+        for (d = MYMAN_UP; d <= MYMAN_RIGHT; d++) {
+            size_t next = (size_t)YWRAP(r + YDIR(d)) * (maze_w + 1) +
+                          XWRAP(c + XDIR(d));
+
+            if (EYES_PASS(cells[next]) && (home_dist[next] == HOME_UNREACHED)) {
+                home_dist[next] = (uint16_t)(home_dist[k] + 1);
+                queue[tail++]   = (int)next;
+            }
+        }
+    }
+    free((void*)queue);
+}
+
+/**
+ * @brief Bring the current level's route tables up to date
+ *
+ * Numbers the open runs of every row and column (row_run, col_run),
+ * resolves every zap cell to the column or row it sends the hero to
+ * (zap_to) and measures how many steps each cell is from the ghost pen
+ * (home_dist), all from the live maze. Does nothing while route_level
+ * says the tables still describe the current level; maze writes that
+ * change which cells are open or zaps mark them stale.
+ */
+void maze_routes(void) {
+    const char* cells;
+    int         i, j;
+    uint16_t    run;
+
+    if (route_level == maze_level + 1)
+        return;
+    cells = maze + maze_level * maze_h * (maze_w + 1);
+    for (j = 0; j < maze_h; j++) {
+        run = 0;
+        for (i = 0; i <= maze_w; i++) {
+            unsigned c = (unsigned)(unsigned char)cells[j * (maze_w + 1) + i];
+
+            if (!ISOPEN(c))
+                run = 0;
+            else if (!run)
+                run = (uint16_t)(i + 1);
+            row_run[j * (maze_w + 1) + i] = run;
+            zap_to[j * (maze_w + 1) + i] =
+                ((i < maze_w) && (CELL_CLASS(c) & CELL_ZAP))
+                    ? (uint16_t)find_zap_exit(cells, i, j)
+                    : 0;
+        }
+    }
+    for (i = 0; i <= maze_w; i++) {
+        run = 0;
+        for (j = 0; j < maze_h; j++) {
+            if (!ISOPEN((unsigned)(unsigned char)cells[j * (maze_w + 1) + i]))
+                run = 0;
+            else if (!run)
+                run = (uint16_t)(j + 1);
+            col_run[j * (maze_w + 1) + i] = run;
+        }
+    }
+    find_home_dist(cells);
+    route_level = maze_level + 1;
+}
+
+/**
+ * @brief Look up where a zap cell of the current level leads
+ *
+ * @param x Column of the cell (tile coordinates)
+ * @param y Row of the cell (tile coordinates)
+ * @return The column a '<' or '>' cell, or the row a '^' or 'v' cell,
+ *         sends the hero to; -1 if (x, y) is not a zap cell
+ */
+int maze_zap_to(int x, int y) {
+    maze_routes();
+    if (!(CELL_CLASS((unsigned)(unsigned char)
+                         maze[(maze_level * maze_h + y) * (maze_w + 1) + x]) &
+          CELL_ZAP))
+        return -1;
+    return zap_to[y * (maze_w + 1) + x];
+}
+
+/**
+ * @brief Can a ghost at tile (i1, j1) see the hero at tile (i2, j2)?
+ *
+ * True when both are in the same column (or else the same row) and
+ * every cell between them is open, without wrapping around the maze
+ * edge. Answered from the open runs numbered by maze_routes().
+ */
+static int hero_in_sight(int i1, int j1, int i2, int j2) {
+    uint16_t run;
+
+    maze_routes();
+    if (i1 == i2) {
+        run = col_run[j1 * (maze_w + 1) + i1];
+        return run && (run == col_run[j2 * (maze_w + 1) + i2]);
+    }
+    if (j1 == j2) {
+        run = row_run[j1 * (maze_w + 1) + i1];
+        return run && (run == row_run[j2 * (maze_w + 1) + i2]);
+    }
+    return 0;
+}
+
+/* the way on from (r, c) - straight ahead (dir1) or a turn (dir0,
+ * dir2) - that is fewest steps from the ghost pen; 0 in the pen itself
+ * and where the pen cannot be reached */
+static int home_turn(int r, int c, int dir0, int dir1, int dir2) {
+    const int ways[3] = {dir1, dir2, dir0};
+    unsigned  here, best = HOME_UNREACHED;
+    int       way        = 0;
+    int       k;
+
+    maze_routes();
+    here = home_dist[r * (maze_w + 1) + c];
+    if ((!here) || (here == HOME_UNREACHED))
+        return 0;
+    for (k = 0; k < 3; k++) {
+        unsigned n = home_dist[YWRAP(r + YDIR(ways[k])) * (maze_w + 1) +
+                               XWRAP(c + XDIR(ways[k]))];
+
+        if (n < best) {
+            best = n;
+            way  = ways[k];
+        }
+    }
+    return way;
+}
+
 static void ghost_eaten_timer_expired(void) {
     sprite_register_used[GHOST_SCORE] = 0;
     sprite_register_frame[GHOST_SCORE]++;
@@ -87,12 +277,9 @@ static void ghost_eaten_timer_expired(void) {
                (void*)(blank_maze_color +
                        (maze_level * maze_h + rmsg) * (maze_w + 1) + cmsg),
                MIN(msglen, maze_w - cmsg));
-        {
-            int dirty_i;
-            for (dirty_i = 0; dirty_i < msglen; dirty_i++) {
-                mark_cell(cmsg + dirty_i, rmsg);
-            }
-        }
+        route_level = 0;
+        glyph_level = 0;
+        mark_rect(cmsg, rmsg, cmsg + msglen - 1, rmsg);
         myman_sfx |= myman_sfx_siren0_up;
     } else {
         sprite_register_used[HERO] = NET_LIVES ? 1 : 0;
@@ -102,9 +289,8 @@ static void ghost_eaten_timer_expired(void) {
 }
 
 static int check_level_transition(void) {
-    int        reset = 0;
-    static int init  = 0;
-    int        i;
+    int reset = 0;
+    int i;
 
     if (!need_reset) {
         if (dying && !--dying) {
@@ -128,6 +314,8 @@ static int check_level_transition(void) {
                (maze_w + 1) * maze_h * maze_n * sizeof(unsigned char));
         memcpy((void*)maze_color, (void*)blank_maze_color,
                (maze_w + 1) * maze_h * maze_n * sizeof(unsigned char));
+        route_level = 0;
+        glyph_level = 0;
         DIRTY_ALL();
         ignore_delay = 1;
         frameskip    = 0;
@@ -135,15 +323,9 @@ static int check_level_transition(void) {
         pellet_timer = 0;
         pellet_time -= PELLET_ADJUST(7 * ONESEC);
         if (level && (FLIP_ALWAYS || INTERMISSION(level))) {
-            ++maze_level;
-            maze_level %= maze_n;
-            if (!maze_level) {
-                maze_level = flip_to % maze_n;
-            }
-            if (FLIP_LOCK && !maze_level) {
-                maze_level = maze_n - 1;
-            }
+            maze_level = maze_level_after(maze_level);
         }
+        maze_prepare(maze_level);
         if (INTERMISSION(level) && (intermission < INTERMISSION_N)) {
             ++intermission_shown;
             if (intermission_shown >= INTERMISSION_REPEAT(intermission)) {
@@ -166,8 +348,8 @@ static int check_level_transition(void) {
             }
         }
     }
-    if ((!init) && (winning || reset)) {
-        init = 1;
+    if ((!game_ctx->level_init) && (winning || reset)) {
+        game_ctx->level_init = 1;
         if (sprite_register_used[FRUIT]) {
             DIRTY_ALL();
             ignore_delay = 1;
@@ -187,7 +369,6 @@ static int check_level_transition(void) {
         sprite_register_frame[HERO] = 0;
     }
     if (reset) {
-        memset((void*)home_dir, 0, sizeof(home_dir));
         for (i = 0; i < ghosts; i++) {
             int eyes, mean, blue;
 
@@ -209,7 +390,7 @@ static int check_level_transition(void) {
                      (int)(YGHOST - ROGHOST * gfx_h * (i == GHOST1)));
         }
         key_buffer                  = key_buffer_ERR;
-        init                        = 0;
+        game_ctx->level_init        = 0;
         cycles                      = 0;
         sprite_register_used[HERO]  = 0;
         sprite_register_frame[HERO] = 0;
@@ -270,12 +451,9 @@ static void reset_hero(void) {
                 (void*)(blank_maze_color +
                         (maze_level * maze_h + rmsg2) * (maze_w + 1) + cmsg2),
                 MIN(msglen, maze_w - cmsg2));
-            {
-                int dirty_i;
-                for (dirty_i = 0; dirty_i < msglen; dirty_i++) {
-                    mark_cell(cmsg2 + dirty_i, rmsg2);
-                }
-            }
+            route_level = 0;
+            glyph_level = 0;
+            mark_rect(cmsg2, rmsg2, cmsg2 + msglen - 1, rmsg2);
         }
         hero_dir              = dirhero;
         sprite_register[HERO] = SPRITE_HERO + ((hero_dir == MYMAN_LEFT)    ? 4
@@ -306,6 +484,8 @@ static void reset_hero(void) {
  * - Level completion and transitions
  * - Bonus life awards (10000 and 50000 points)
  *
+ * @param ctx Session to advance; becomes the current context
+ *
  * @return 1 if game should continue, 0 if game over or exit requested
  *
  * @note Called once per game cycle (60fps typical)
@@ -313,14 +493,15 @@ static void reset_hero(void) {
  * @note Modifies global game state (score, lives, level)
  * @see gamecycle, check_collision, find_home_dir
  */
-int gamelogic(void) {
+int gamelogic(game_context_t* ctx) {
     int  xtile, ytile;
     int  x_off, y_off;
     long c = 0;
-    int  i, j;
     int  s;
     int  collision_type = 0;
 
+    game_ctx = ctx;
+
     xtile = XTILE(sprite_register_x[HERO]);
     ytile = YTILE(sprite_register_y[HERO]);
     x_off = sprite_register_x[HERO] % gfx_w;
@@ -345,6 +526,7 @@ int gamelogic(void) {
             ISDOT(c)) {
             maze[(maze_level * maze_h + ytile) * (maze_w + 1) + xtile] = ' ';
             sprite_register_frame[HERO]                                = 0;
+            maze_glyph_cell(xtile, ytile);
             if (!myman_demo)
                 score += 10 + 40 * ISPELLET(c);
             if (ISPELLET(c)) {
@@ -416,71 +598,29 @@ int gamelogic(void) {
                         maze[(maze_level * maze_h + ytile) * (maze_w + 1) +
                              xtile]) &&
                 (!YDIR(hero_dir)) && (hero_dir == MYMAN_LEFT)) {
-                int ii;
-
-                for (ii = 1; ii < maze_w; ii++) {
-                    if (ISZAPRIGHT((unsigned)(unsigned char)
-                                       maze[(maze_level * maze_h + ytile) *
-                                                (maze_w + 1) +
-                                            XWRAP(xtile - ii)])) {
-                        break;
-                    }
-                }
                 sprite_register_x[HERO] =
-                    (1 + 2 * XWRAP(xtile - ii)) * gfx_w / 2;
+                    (1 + 2 * maze_zap_to(xtile, ytile)) * gfx_w / 2;
             } else if (ISZAPRIGHT((unsigned)(unsigned char)
                                       maze[(maze_level * maze_h + ytile) *
                                                (maze_w + 1) +
                                            xtile]) &&
                        (!YDIR(hero_dir)) && (hero_dir == MYMAN_RIGHT)) {
-                int ii;
-
-                for (ii = 1; ii < maze_w; ii++) {
-                    if (ISZAPLEFT((unsigned)(unsigned char)
-                                      maze[(maze_level * maze_h + ytile) *
-                                               (maze_w + 1) +
-                                           XWRAP(xtile + ii)])) {
-                        break;
-                    }
-                }
                 sprite_register_x[HERO] =
-                    (1 + 2 * XWRAP(xtile + ii)) * gfx_w / 2;
+                    (1 + 2 * maze_zap_to(xtile, ytile)) * gfx_w / 2;
             } else if (ISZAPUP((unsigned)(unsigned char)
                                    maze[(maze_level * maze_h + ytile) *
                                             (maze_w + 1) +
                                         xtile]) &&
                        (!XDIR(hero_dir)) && (hero_dir == MYMAN_UP)) {
-                int ii;
-
-                for (ii = 1; ii < maze_h; ii++) {
-                    if (ISZAPDOWN(
-                            (unsigned)(unsigned char)
-                                maze[(maze_level * maze_h + YWRAP(ytile - ii)) *
-                                         (maze_w + 1) +
-                                     xtile])) {
-                        break;
-                    }
-                }
                 sprite_register_y[HERO] =
-                    (1 + 2 * YWRAP(ytile - ii)) * gfx_h / 2;
+                    (1 + 2 * maze_zap_to(xtile, ytile)) * gfx_h / 2;
             } else if (ISZAPDOWN((unsigned)(unsigned char)
                                      maze[(maze_level * maze_h + ytile) *
                                               (maze_w + 1) +
                                           xtile]) &&
                        (!XDIR(hero_dir)) && (hero_dir == MYMAN_DOWN)) {
-                int ii;
-
-                for (ii = 1; ii < maze_h; ii++) {
-                    if (ISZAPUP(
-                            (unsigned)(unsigned char)
-                                maze[(maze_level * maze_h + YWRAP(ytile + ii)) *
-                                         (maze_w + 1) +
-                                     xtile])) {
-                        break;
-                    }
-                }
                 sprite_register_y[HERO] =
-                    (1 + 2 * YWRAP(ytile + ii)) * gfx_h / 2;
+                    (1 + 2 * maze_zap_to(xtile, ytile)) * gfx_h / 2;
             } else {
                 unsigned char m3;
                 int           x3, y3;
@@ -541,58 +681,9 @@ int gamelogic(void) {
                         j1 = YTILE(y);
                         i2 = XTILE(sprite_register_x[HERO]);
                         j2 = YTILE(sprite_register_y[HERO]);
-                        if ((i1 == i2) && (j1 <= j2)) {
-                            for (j = j1; j <= j2; j++) {
-                                mcell = (unsigned char)
-                                    maze[(maze_level * maze_h + j) *
-                                             (maze_w + 1) +
-                                         i1];
-                                if (!ISOPEN((unsigned)mcell))
-                                    break;
-                            }
-                            if (j > j2) {
-                                ghost_mem[s]   = hero_dir;
-                                ghost_timer[s] = (int)MEMDELAY(s);
-                            }
-                        } else if ((i1 == i2) && (j1 >= j2)) {
-                            for (j = j2; j <= j1; j++) {
-                                mcell = (unsigned char)
-                                    maze[(maze_level * maze_h + j) *
-                                             (maze_w + 1) +
-                                         i1];
-                                if (!ISOPEN((unsigned)mcell))
-                                    break;
-                            }
-                            if (j > j1) {
-                                ghost_mem[s]   = hero_dir;
-                                ghost_timer[s] = (int)MEMDELAY(s);
-                            }
-                        } else if ((j1 == j2) && (i1 <= i2)) {
-                            for (i = i1; i <= i2; i++) {
-                                mcell = (unsigned char)
-                                    maze[(maze_level * maze_h + j1) *
-                                             (maze_w + 1) +
-                                         i];
-                                if (!ISOPEN((unsigned)mcell))
-                                    break;
-                            }
-                            if (i > i2) {
-                                ghost_mem[s]   = hero_dir;
-                                ghost_timer[s] = (int)MEMDELAY(s);
-                            }
-                        } else if ((j1 == j2) && (i1 >= i2)) {
-                            for (i = i2; i <= i1; i++) {
-                                mcell = (unsigned char)
-                                    maze[(maze_level * maze_h + j1) *
-                                             (maze_w + 1) +
-                                         i];
-                                if (!ISOPEN((unsigned)mcell))
-                                    break;
-                            }
-                            if (i > i1) {
-                                ghost_mem[s]   = hero_dir;
-                                ghost_timer[s] = (int)MEMDELAY(s);
-                            }
+                        if (hero_in_sight(i1, j1, i2, j2)) {
+                            ghost_mem[s]   = hero_dir;
+                            ghost_timer[s] = (int)MEMDELAY(s);
                         }
                         mcell = (unsigned char)maze[(maze_level * maze_h +
                                                      YWRAP(j1 + YDIR(dir0))) *
@@ -640,16 +731,6 @@ int gamelogic(void) {
                             sprite_register_x[blue] = XPIXWRAP(x + XDIR(dir1));
                         if ((gfx_reflect && !MYMANSQUARE) ? 1 : (cycles & 2))
                             sprite_register_y[blue] = YPIXWRAP(y + YDIR(dir1));
-                        if (!(unsigned)
-                                home_dir[(s % ghosts * maze_h +
-                                          YTILE(sprite_register_y[blue])) *
-                                             (maze_w + 1) +
-                                         XTILE(sprite_register_x[blue])])
-                            home_dir[(s % ghosts * maze_h +
-                                      YTILE(sprite_register_y[blue])) *
-                                         (maze_w + 1) +
-                                     XTILE(sprite_register_x[blue])] =
-                                DIRWRAP(dir1 + 2);
                     }
                 } else if (sprite_register_used[mean] && !ghost_eaten_timer) {
                     /* out huntin' */
@@ -661,54 +742,9 @@ int gamelogic(void) {
                     j1 = YTILE(y);
                     i2 = XTILE(sprite_register_x[HERO]);
                     j2 = YTILE(sprite_register_y[HERO]);
-                    if ((i1 == i2) && (j1 <= j2)) {
-                        for (j = j1; j <= j2; j++) {
-                            mcell = (unsigned char)
-                                maze[(maze_level * maze_h + j) * (maze_w + 1) +
-                                     i1];
-                            if (!ISOPEN((unsigned)mcell))
-                                break;
-                        }
-                        if (j > j2) {
-                            ghost_mem[s]   = hero_dir;
-                            ghost_timer[s] = (int)MEMDELAY(s);
-                        }
-                    } else if ((i1 == i2) && (j1 >= j2)) {
-                        for (j = j2; j <= j1; j++) {
-                            mcell = (unsigned char)
-                                maze[(maze_level * maze_h + j) * (maze_w + 1) +
-                                     i1];
-                            if (!ISOPEN((unsigned)mcell))
-                                break;
-                        }
-                        if (j > j1) {
-                            ghost_mem[s]   = hero_dir;
-                            ghost_timer[s] = (int)MEMDELAY(s);
-                        }
-                    } else if ((j1 == j2) && (i1 <= i2)) {
-                        for (i = i1; i <= i2; i++) {
-                            mcell = (unsigned char)
-                                maze[(maze_level * maze_h + j1) * (maze_w + 1) +
-                                     i];
-                            if (!ISOPEN((unsigned)mcell))
-                                break;
-                        }
-                        if (i > i2) {
-                            ghost_mem[s]   = hero_dir;
-                            ghost_timer[s] = (int)MEMDELAY(s);
-                        }
-                    } else if ((j1 == j2) && (i1 >= i2)) {
-                        for (i = i2; i <= i1; i++) {
-                            mcell = (unsigned char)
-                                maze[(maze_level * maze_h + j1) * (maze_w + 1) +
-                                     i];
-                            if (!ISOPEN((unsigned)mcell))
-                                break;
-                        }
-                        if (i > i1) {
-                            ghost_mem[s]   = hero_dir;
-                            ghost_timer[s] = (int)MEMDELAY(s);
-                        }
+                    if (hero_in_sight(i1, j1, i2, j2)) {
+                        ghost_mem[s]   = hero_dir;
+                        ghost_timer[s] = (int)MEMDELAY(s);
                     }
                     mcell = (unsigned char)
                         maze[(maze_level * maze_h + YWRAP(j1 + YDIR(dir0))) *
@@ -746,15 +782,15 @@ int gamelogic(void) {
                         d2    = ISDOOR((unsigned)mcell);
                     }
                     d0 = d0 &&
-                         (dir0 != find_home_dir(s, YWRAP(j1 + YDIR(dir0)),
+                         (dir0 != find_home_dir(YWRAP(j1 + YDIR(dir0)),
                                                 XWRAP(i1 + XDIR(dir0)))) &&
                          dir0 != MYMAN_DOWN && dir0 != MYMAN_LEFT;
                     d2 = d2 &&
-                         (dir2 != find_home_dir(s, YWRAP(j1 + YDIR(dir2)),
+                         (dir2 != find_home_dir(YWRAP(j1 + YDIR(dir2)),
                                                 XWRAP(i1 + XDIR(dir2)))) &&
                          dir2 != MYMAN_DOWN && dir2 != MYMAN_LEFT;
                     d1 = d1 &&
-                         (dir1 != find_home_dir(s, YWRAP(j1 + YDIR(dir1)),
+                         (dir1 != find_home_dir(YWRAP(j1 + YDIR(dir1)),
                                                 XWRAP(i1 + XDIR(dir1)))) &&
                          dir1 != MYMAN_DOWN && dir1 != MYMAN_LEFT;
                     if (((gfx_w / 2 == x % gfx_w) && XDIR(dir1)) ||
@@ -786,21 +822,11 @@ int gamelogic(void) {
                         sprite_register_y[mean] =
                             (sprite_register_y[eyes] =
                                  YPIXWRAP(y + YDIR(dir1)));
-                    if (!(unsigned)home_dir[(s % ghosts * maze_h +
-                                             YTILE(sprite_register_y[mean])) *
-                                                (maze_w + 1) +
-                                            XTILE(sprite_register_x[mean])])
-                        home_dir[(s % ghosts * maze_h +
-                                  YTILE(sprite_register_y[mean])) *
-                                     (maze_w + 1) +
-                                 XTILE(sprite_register_x[mean])] =
-                            DIRWRAP(dir1 + 2);
                 } else if (sprite_register_used[eyes] &&
                            ((munched != eyes) || (!ghost_eaten_timer)) &&
                            ((!ghost_eaten_timer) ||
                             !sprite_register_used[MEANGHOST(s)])) {
-                    int           dx, dy;
-                    unsigned char d, d1 = 0;
+                    int dx, dy, d;
 
                     /* goin' home */
                     ghost_timer[s] = (int)MEMDELAY(s);
@@ -810,15 +836,9 @@ int gamelogic(void) {
                     j1             = YTILE(y);
                     dx             = (int)((XGHOST - x) / gfx_w);
                     dy             = (int)(((dx ? YTOP : YGHOST) - y) / gfx_h);
-                    d              = find_home_dir(s, j1, i1);
-                    if ((unsigned)d)
-                        d1 = (unsigned)DIRWRAP(
-                            find_home_dir(s, YWRAP(j1 + YDIR((unsigned)d)),
-                                          XWRAP(i1 + XDIR((unsigned)d))) +
-                            2);
-                    if (((unsigned)d) &&
-                        (!(((unsigned)d1) && (((unsigned)d1) == (unsigned)d))))
-                        ghost_mem[s] = (unsigned)d;
+                    d              = home_turn(j1, i1, dir0, dir1, dir2);
+                    if (d)
+                        ghost_mem[s] = d;
                     else {
                         if (dx * dx > dy * dy) {
                             if (dx > 0)
@@ -876,15 +896,6 @@ int gamelogic(void) {
                         (sprite_register_x[eyes] = XPIXWRAP(x + XDIR(dir1)));
                     sprite_register_x[eyes] = XPIXWRAP(x + XDIR(dir1));
                     sprite_register_y[eyes] = YPIXWRAP(y + YDIR(dir1));
-                    if (!(unsigned)home_dir[(s % ghosts * maze_h +
-                                             YTILE(sprite_register_y[eyes])) *
-                                                (maze_w + 1) +
-                                            XTILE(sprite_register_x[eyes])])
-                        home_dir[(s % ghosts * maze_h +
-                                  YTILE(sprite_register_y[eyes])) *
-                                     (maze_w + 1) +
-                                 XTILE(sprite_register_x[eyes])] =
-                            DIRWRAP(dir1 + 2);
                 }
                 if ((!ghost_eaten_timer) && ghost_timer[s] &&
                     !--ghost_timer[s]) {
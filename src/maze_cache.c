@@ -0,0 +1,328 @@
+/* maze_cache.c - On-disk cache of loaded and painted mazes
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/* mmap(), mkdir() and getpid() */
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "globals.h"
+#include "utils.h"
+
+/*
+ * A cache entry holds everything readmaze() and paint_walls() work out
+ * from a maze file, which depends on nothing but the file's bytes. It
+ * is named after a hash of those bytes and laid out as:
+ *
+ *   maze_cache_header_t
+ *   total_dots[n], pellets[n]          (int)
+ *   inside_wall[n * h * (w + 1)]       (uint16_t)
+ *   maze[n * h * (w + 1)]              (as loaded, before any play)
+ *   maze_color[n * h * (w + 1)]
+ *   maze_args[args_len]                (NUL-terminated, if any)
+ *
+ * Bump MAZE_CACHE_VERSION whenever the parser, the wall painting or
+ * this layout changes, so stale entries are ignored and rewritten.
+ */
+#define MAZE_CACHE_MAGIC "glomphmc"
+#define MAZE_CACHE_VERSION 1
+#define MAZE_CACHE_ORDER 0x01020304UL
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t order; /* MAZE_CACHE_ORDER, to reject other byte orders */
+    uint64_t key;   /* hash of the maze file */
+    uint64_t size;  /* length of the maze file */
+    int32_t  n, w, h, flags;
+    uint32_t args_len; /* including the NUL, or 0 without maze_args */
+    uint32_t unused;
+} maze_cache_header_t;
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t fnv1a(uint64_t h, const void* data, size_t len) {
+    const unsigned char* p = (const unsigned char*)data;
+
+    while (len--) {
+        h ^= *p++;
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+/* the maze file being loaded, and the cache entry it goes with */
+static uint64_t cache_key  = 0;
+static uint64_t cache_size = 0;
+static char*    cache_path = NULL;
+
+/* the cache entry mapped by a hit, until maze_cache_paint() */
+static void*  cache_map     = NULL;
+static size_t cache_map_len = 0;
+
+/* hash the bytes of mazefile, found the way readmaze() finds it */
+static int maze_file_key(const char* mazefile, uint64_t* key,
+                         uint64_t* size) {
+    unsigned char buf[BUFSIZ];
+    FILE*         infile;
+    size_t        len;
+
+    infile = fopen_datafile(mazefile, "rb");
+    if (!infile)
+        return 1;
+    *key  = FNV_OFFSET;
+    *size = 0;
+    while ((len = fread((void*)buf, 1, sizeof(buf), infile)) > 0) {
+        *key = fnv1a(*key, buf, len);
+        *size += len;
+    }
+    if (ferror(infile)) {
+        fclose(infile);
+        return 1;
+    }
+    fclose(infile);
+    return 0;
+}
+
+/* $XDG_CACHE_HOME/glomph-maze/<key>, or ~/.cache/glomph-maze/<key> */
+static char* maze_cache_name(uint64_t key) {
+    const char* base = myman_getenv("XDG_CACHE_HOME");
+    const char* dir  = "glomph-maze";
+    char*       path;
+    size_t      len;
+
+    /* relative paths in XDG_CACHE_HOME are to be ignored */
+    if ((!base) || (*base != '/')) {
+        base = myman_getenv("HOME");
+        dir  = ".cache/glomph-maze";
+    }
+    if ((!base) || (!*base))
+        return NULL;
+    len  = strlen(base) + 1 + strlen(dir) + 1 + 16 + 1;
+    path = (char*)malloc(len);
+    if (!path)
+        return NULL;
+    snprintf(path, len, "%s/%s/%016llx", base, dir,
+             (unsigned long long)key);
+    return path;
+}
+
+/* bytes of a cache entry for the given header, or 0 if it is absurd */
+static size_t maze_cache_length(const maze_cache_header_t* hdr) {
+    size_t cells;
+
+    if ((hdr->n < 1) || (hdr->w < 1) || (hdr->h < 1))
+        return 0;
+    cells = (size_t)hdr->n * hdr->h * ((size_t)hdr->w + 1);
+    return sizeof(*hdr) + 2 * hdr->n * sizeof(*total_dots) +
+           cells * sizeof(*inside_wall) + 2 * cells + hdr->args_len;
+}
+
+/**
+ * @brief Load a maze from the maze cache, if it is there
+ *
+ * Hashes @p mazefile and looks for a cache entry for it. On a hit the
+ * entry is mapped with a single mmap(), and maze_n, maze_w, maze_h,
+ * maze_flags, maze_args, maze and maze_color are set up from it just
+ * as readmaze() would have. Either way, maze_cache_paint() must be
+ * called once init_maze() has run.
+ *
+ * @param mazefile Path to maze file (searched as by readmaze())
+ *
+ * @return 1 on a hit, 0 if readmaze() is needed
+ *
+ * @note Exits on allocation failure
+ * @see maze_cache_paint, readmaze
+ */
+int maze_cache_load(const char* mazefile) {
+    const maze_cache_header_t* hdr;
+    const char*                data;
+    struct stat                st;
+    size_t                     cells;
+    int                        fd;
+
+    free((void*)cache_path);
+    cache_path = NULL;
+    if (maze_file_key(mazefile, &cache_key, &cache_size))
+        return 0;
+    cache_path = maze_cache_name(cache_key);
+    if (!cache_path)
+        return 0;
+    fd = open(cache_path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) || ((size_t)st.st_size < sizeof(*hdr))) {
+        close(fd);
+        return 0;
+    }
+    cache_map_len = (size_t)st.st_size;
+    cache_map = mmap(NULL, cache_map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (cache_map == MAP_FAILED) {
+        cache_map = NULL;
+        return 0;
+    }
+    hdr = (const maze_cache_header_t*)cache_map;
+    if (memcmp(hdr->magic, MAZE_CACHE_MAGIC, sizeof(hdr->magic)) ||
+        (hdr->version != MAZE_CACHE_VERSION) ||
+        (hdr->order != MAZE_CACHE_ORDER) || (hdr->key != cache_key) ||
+        (hdr->size != cache_size) ||
+        (maze_cache_length(hdr) != cache_map_len) ||
+        (hdr->args_len && ((const char*)cache_map)[cache_map_len - 1])) {
+        munmap(cache_map, cache_map_len);
+        cache_map = NULL;
+        return 0;
+    }
+    maze_n     = hdr->n;
+    maze_w     = hdr->w;
+    maze_h     = hdr->h;
+    maze_flags = hdr->flags;
+    cells      = (size_t)maze_n * maze_h * (maze_w + 1);
+    data       = (const char*)(hdr + 1) + 2 * maze_n * sizeof(*total_dots) +
+           cells * sizeof(*inside_wall);
+    game_ctx->maze       = (char*)malloc(cells * sizeof(*game_ctx->maze));
+    game_ctx->maze_color = (char*)malloc(cells * sizeof(*game_ctx->maze_color));
+    if ((!game_ctx->maze) || (!game_ctx->maze_color)) {
+        perror("malloc");
+        exit(1);
+    }
+    memcpy((void*)game_ctx->maze, (const void*)data, cells);
+    memcpy((void*)game_ctx->maze_color, (const void*)(data + cells), cells);
+    maze_args = NULL;
+    if (hdr->args_len) {
+        maze_args = strdup(data + 2 * cells);
+        if (!maze_args) {
+            perror("strdup");
+            exit(1);
+        }
+    }
+    return 1;
+}
+
+/* write the loaded, fully painted maze to its cache entry; runs on the
+ * prefetch thread, and only reads data that no longer changes */
+static void maze_cache_store(void) {
+    maze_cache_header_t hdr;
+    char*               tmp;
+    char*               sep;
+    FILE*               outfile;
+    size_t              cells, len;
+    int                 ok;
+
+    memset((void*)&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, MAZE_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version  = MAZE_CACHE_VERSION;
+    hdr.order    = MAZE_CACHE_ORDER;
+    hdr.key      = cache_key;
+    hdr.size     = cache_size;
+    hdr.n        = maze_n;
+    hdr.w        = maze_w;
+    hdr.h        = maze_h;
+    hdr.flags    = maze_flags;
+    hdr.args_len = maze_args ? (uint32_t)(strlen(maze_args) + 1) : 0;
+    cells        = (size_t)maze_n * maze_h * (maze_w + 1);
+    len          = strlen(cache_path) + 32;
+    tmp          = (char*)malloc(len);
+    if (!tmp)
+        return;
+    /* create the directories on the way, as mkdir -p would */
+    strcpy(tmp, cache_path);
+    for (sep = strchr(tmp + 1, '/'); sep; sep = strchr(sep + 1, '/')) {
+        *sep = '\0';
+        mkdir(tmp, 0777);
+        *sep = '/';
+    }
+    /* write to a temporary file and rename it into place, so a reader
+     * never sees half an entry */
+    snprintf(tmp, len, "%s.%ld.tmp", cache_path, (long)getpid());
+    outfile = fopen(tmp, "wb");
+    if (!outfile) {
+        free((void*)tmp);
+        return;
+    }
+    /* the blank copies, since the game has been playing on maze */
+    ok = (fwrite((void*)&hdr, sizeof(hdr), 1, outfile) == 1) &&
+         (fwrite((void*)total_dots, sizeof(*total_dots), maze_n, outfile) ==
+          (size_t)maze_n) &&
+         (fwrite((void*)pellets, sizeof(*pellets), maze_n, outfile) ==
+          (size_t)maze_n) &&
+         (fwrite((void*)inside_wall, sizeof(*inside_wall), cells, outfile) ==
+          cells) &&
+         (fwrite((void*)blank_maze, 1, cells, outfile) == cells) &&
+         (fwrite((void*)blank_maze_color, 1, cells, outfile) == cells) &&
+         ((!hdr.args_len) ||
+          (fwrite((void*)maze_args, hdr.args_len, 1, outfile) == 1));
+    if (fclose(outfile))
+        ok = 0;
+    if ((!ok) || rename(tmp, cache_path))
+        unlink(tmp);
+    free((void*)tmp);
+}
+
+/**
+ * @brief Paint the walls of the maze loaded by maze_cache_load()
+ *
+ * On a cache hit, copies inside_wall, total_dots and pellets from the
+ * cache entry and unmaps it; nothing needs painting. On a miss, levels
+ * are painted as they come up (see paint_walls_on_demand()) and the
+ * rest in the background, after which the cache entry is written for
+ * next time. Mazes without a cache entry, such as the built-in one,
+ * are just painted on demand.
+ *
+ * @note Call after init_maze(), in place of paint_walls_on_demand()
+ * @see maze_cache_load, paint_walls_then
+ */
+void maze_cache_paint(void) {
+    const char* data;
+    size_t      cells;
+
+    if (!cache_map) {
+        if (cache_path)
+            paint_walls_then(maze_cache_store);
+        else
+            paint_walls_on_demand();
+        return;
+    }
+    cells = (size_t)maze_n * maze_h * (maze_w + 1);
+    data  = (const char*)cache_map + sizeof(maze_cache_header_t);
+    memcpy((void*)total_dots, (const void*)data,
+           maze_n * sizeof(*total_dots));
+    data += maze_n * sizeof(*total_dots);
+    memcpy((void*)pellets, (const void*)data, maze_n * sizeof(*pellets));
+    data += maze_n * sizeof(*pellets);
+    memcpy((void*)inside_wall, (const void*)data,
+           cells * sizeof(*inside_wall));
+    munmap(cache_map, cache_map_len);
+    cache_map = NULL;
+    paint_walls_loaded();
+}
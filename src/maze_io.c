@@ -23,13 +23,128 @@
  *  DEALINGS IN THE SOFTWARE.
  */
 
+/* fileno() and mmap() */
+#define _POSIX_C_SOURCE 200809L
+
 #include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "globals.h"
 #include "utils.h"
+#include "game_context_aliases.h"
+
+/*
+ * The .gmz format is a maze as readmaze() leaves it in memory, so it
+ * can be mapped instead of parsed:
+ *
+ *   gmz_header_t
+ *   maze_args                    (as readmaze() returns it, with NUL)
+ *   cells[n * h * (w + 1)]       (level after level, GMZ_ALIGN aligned)
+ *   colors[n * h * (w + 1)]      (likewise)
+ *
+ * writemaze_gmz() writes one, and readmaze() recognizes one by its
+ * magic whatever the file is called. The fields are in the writer's
+ * byte order; GMZ_ORDER rejects files from the other kind of machine.
+ */
+#define GMZ_MAGIC "glomphmz"
+#define GMZ_VERSION 1
+#define GMZ_ORDER 0x01020304UL
+#define GMZ_ALIGN 64
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t order;
+    int32_t  n, w, h, flags;
+    uint64_t args_off; /* 0 without maze_args */
+    uint64_t args_len; /* including the NUL */
+    uint64_t cells_off;
+    uint64_t color_off;
+} gmz_header_t;
+
+/* the cells the last .gmz readmaze() mapped, and its pristine planes
+ * for init_maze() to use as blank_maze and blank_maze_color */
+static const char* gmz_cells       = NULL;
+static const char* gmz_blank       = NULL;
+static const char* gmz_blank_color = NULL;
+
+/* readmaze() for a .gmz file: map it twice, once read-only for the
+ * pristine planes and maze_args, and once copy-on-write for the planes
+ * the game plays on, which are only copied a page at a time as they
+ * are written to */
+static int readmaze_gmz(const char* mazefile, FILE* infile, int* levels,
+                        int* w, int* h, char** cells, int* flags,
+                        char** color, const char** args) {
+    const gmz_header_t* hdr;
+    const char*         blank;
+    char*               map;
+    struct stat         st;
+    size_t              len, planes;
+
+    if (fstat(fileno(infile), &st)) {
+        perror(mazefile);
+        return 1;
+    }
+    len = (size_t)st.st_size;
+    if (len < sizeof(*hdr)) {
+        fprintf(stderr, "%s: premature EOF\n", mazefile);
+        return 1;
+    }
+    blank = (const char*)mmap(NULL, len, PROT_READ, MAP_PRIVATE,
+                              fileno(infile), 0);
+    if (blank == (const char*)MAP_FAILED) {
+        perror(mazefile);
+        return 1;
+    }
+    hdr = (const gmz_header_t*)blank;
+    if ((hdr->version != GMZ_VERSION) || (hdr->order != GMZ_ORDER)) {
+        fprintf(stderr, "%s: unsupported .gmz version or byte order\n",
+                mazefile);
+        munmap((void*)blank, len);
+        return 1;
+    }
+    if ((hdr->w < 1) || (hdr->h < 1) || (hdr->n < 1)) {
+        fprintf(stderr, "%s: dimension specification %d %dx%d is too small\n",
+                mazefile, hdr->n, hdr->w, hdr->h);
+        munmap((void*)blank, len);
+        return 1;
+    }
+    planes = (size_t)hdr->n * hdr->h * ((size_t)hdr->w + 1);
+    if ((hdr->cells_off % GMZ_ALIGN) || (hdr->color_off % GMZ_ALIGN) ||
+        (hdr->cells_off > len) || (planes > len - hdr->cells_off) ||
+        (hdr->color_off > len) || (planes > len - hdr->color_off) ||
+        (hdr->args_off &&
+         ((hdr->args_off > len) || (hdr->args_len < 1) ||
+          (hdr->args_len > len - hdr->args_off) ||
+          blank[hdr->args_off + hdr->args_len - 1]))) {
+        fprintf(stderr, "%s: damaged .gmz file\n", mazefile);
+        munmap((void*)blank, len);
+        return 1;
+    }
+    map = (char*)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                      fileno(infile), 0);
+    if (map == (char*)MAP_FAILED) {
+        perror(mazefile);
+        munmap((void*)blank, len);
+        return 1;
+    }
+    *levels         = hdr->n;
+    *w              = hdr->w;
+    *h              = hdr->h;
+    *flags          = hdr->flags;
+    *args           = hdr->args_off ? (blank + hdr->args_off) : NULL;
+    *cells          = map + hdr->cells_off;
+    *color          = map + hdr->color_off;
+    gmz_cells       = *cells;
+    gmz_blank       = blank + hdr->cells_off;
+    gmz_blank_color = blank + hdr->color_off;
+    return 0;
+}
 
 /**
  * @brief Load maze layout from file
@@ -43,12 +158,14 @@
  * - Optional color map: Per-cell color codes
  *
  * Supports multiple maze levels in single file. Handles CP437/UTF-8 encoding.
+ * Compiled .gmz mazes (see writemaze_gmz()) are mapped instead of parsed.
  *
  * @param mazefile Path to maze file (searched in DATADIR if relative)
  * @param levels Output: number of maze levels in file
  * @param w Output: maze width in characters
  * @param h Output: maze height in characters
- * @param maze Output: allocated maze data buffer (caller must free)
+ * @param cells Output: allocated maze data buffer (caller must free,
+ * unless it was mapped from a .gmz file)
  * @param flags Output: maze rendering flags
  * @param color Output: allocated color map buffer (caller must free, may be
  * NULL)
@@ -60,7 +177,7 @@
  * @note Sets global variables: maze_ABOUT, maze_FIXME, maze_NOTE
  * @see writemaze, parse_maze_args, fopen_datafile
  */
-int readmaze(const char* mazefile, int* levels, int* w, int* h, char** maze,
+int readmaze(const char* mazefile, int* levels, int* w, int* h, char** cells,
              int* flags, char** color, const char** args) {
     char  X;
     int   c = EOF, i, j;
@@ -72,6 +189,21 @@ int readmaze(const char* mazefile, int* levels, int* w, int* h, char** maze,
         perror(mazefile);
         return 1;
     }
+    gmz_cells = NULL;
+    {
+        char magic[sizeof(GMZ_MAGIC) - 1];
+        int  ret;
+
+        if ((fread((void*)magic, 1, sizeof(magic), infile) ==
+             sizeof(magic)) &&
+            !memcmp(magic, GMZ_MAGIC, sizeof(magic))) {
+            ret = readmaze_gmz(mazefile, infile, levels, w, h, cells, flags,
+                               color, args);
+            fclose(infile);
+            return ret;
+        }
+        rewind(infile);
+    }
     ignore_bom_utf8(infile);
     {
         int rn, rw, rh;
@@ -193,12 +325,12 @@ int readmaze(const char* mazefile, int* levels, int* w, int* h, char** maze,
             *args ? *args : "", X);
         return 1;
     }
-    *maze = (char*)malloc(*levels * *h * (*w + 1) * sizeof(**maze));
-    if (!*maze) {
+    *cells = (char*)malloc(*levels * *h * (*w + 1) * sizeof(**cells));
+    if (!*cells) {
         perror("malloc");
         return 1;
     }
-    memset((void*)*maze, 0, *levels * *h * (*w + 1) * sizeof(**maze));
+    memset((void*)*cells, 0, *levels * *h * (*w + 1) * sizeof(**cells));
     *color = (char*)malloc(*levels * *h * (*w + 1) * sizeof(**color));
     if (!*color) {
         perror("malloc");
@@ -218,19 +350,126 @@ int readmaze(const char* mazefile, int* levels, int* w, int* h, char** maze,
                            (c == '\v'))
                     j--;
                 else
-                    (*maze)[(n * *h + i) * (*w + 1) + j] =
+                    (*cells)[(n * *h + i) * (*w + 1) + j] =
                         (char)(unsigned char)c;
             }
             if (ISPELLET(c) || ISDOT(c)) {
                 c = ' ';
             }
-            (*maze)[(n * *h + i) * (*w + 1) + *w] = (char)(unsigned char)c;
+            (*cells)[(n * *h + i) * (*w + 1) + *w] = (char)(unsigned char)c;
         }
     }
     fclose(infile);
     return 0;
 }
 
+/**
+ * @brief Allocate and reset the per-maze working buffers
+ *
+ * Called once the maze has been loaded by readmaze() and its arguments
+ * applied by parse_maze_args(). Allocates the dot/pellet counters, the
+ * pristine copy of the maze (blank_maze; for a .gmz maze, the file
+ * mapping itself), the wall painting map, the
+ * dirty cell bitmap, the route tables (see maze_routes()) and the
+ * visual glyph cache (see maze_glyphs()), then marks every cell
+ * clean. paint_walls() must be run afterwards.
+ *
+ * @note Exits on allocation failure
+ * @see readmaze, paint_walls
+ */
+void init_maze(void) {
+    msglen     = MAX(MAX(strlen(msg_PLAYER1), strlen(msg_PLAYER2)),
+                     MAX(strlen(msg_READY), strlen(msg_GAMEOVER)));
+    total_dots = (int*)malloc(maze_n * sizeof(*total_dots));
+    if (!total_dots) {
+        perror("malloc");
+        exit(1);
+    }
+    memset((void*)total_dots, 0, maze_n * sizeof(*total_dots));
+    pellets = (int*)malloc(maze_n * sizeof(*pellets));
+    if (!pellets) {
+        perror("malloc");
+        exit(1);
+    }
+    memset((void*)pellets, 0, maze_n * sizeof(*pellets));
+    if (gmz_cells && (maze == gmz_cells)) {
+        /* a .gmz maze keeps its pristine planes in the file mapping */
+        blank_maze       = (char*)gmz_blank;
+        blank_maze_color = (char*)gmz_blank_color;
+    } else {
+        blank_maze = (char*)malloc(maze_n * maze_h * (maze_w + 1) *
+                                   sizeof(*blank_maze));
+        if (!blank_maze) {
+            perror("malloc");
+            exit(1);
+        }
+        memcpy((void*)blank_maze, (void*)maze,
+               (maze_w + 1) * maze_h * maze_n * sizeof(unsigned char));
+        blank_maze_color = (char*)malloc(maze_n * maze_h * (maze_w + 1) *
+                                         sizeof(*blank_maze_color));
+        if (!blank_maze_color) {
+            perror("malloc");
+            exit(1);
+        }
+        memcpy((void*)blank_maze_color, (void*)maze_color,
+               (maze_w + 1) * maze_h * maze_n * sizeof(unsigned char));
+    }
+    inside_wall = (unsigned short*)malloc(maze_n * maze_h * (maze_w + 1) *
+                                          sizeof(*inside_wall));
+    if (!inside_wall) {
+        perror("malloc");
+        exit(1);
+    }
+    memset((void*)inside_wall, 0,
+           maze_n * maze_h * (maze_w + 1) * sizeof(*inside_wall));
+    dirty_cell =
+        (uint64_t*)malloc(maze_h * CELL_WORDS * sizeof(*dirty_cell));
+    if (!dirty_cell) {
+        perror("malloc");
+        exit(1);
+    }
+    memset((void*)dirty_cell, 0, maze_h * CELL_WORDS * sizeof(*dirty_cell));
+    row_run = (uint16_t*)malloc(maze_h * (maze_w + 1) * sizeof(*row_run));
+    col_run = (uint16_t*)malloc(maze_h * (maze_w + 1) * sizeof(*col_run));
+    zap_to  = (uint16_t*)malloc(maze_h * (maze_w + 1) * sizeof(*zap_to));
+    home_dist =
+        (uint16_t*)malloc(maze_h * (maze_w + 1) * sizeof(*home_dist));
+    if (!row_run || !col_run || !zap_to || !home_dist) {
+        perror("malloc");
+        exit(1);
+    }
+    memset((void*)row_run, 0, maze_h * (maze_w + 1) * sizeof(*row_run));
+    memset((void*)col_run, 0, maze_h * (maze_w + 1) * sizeof(*col_run));
+    memset((void*)zap_to, 0, maze_h * (maze_w + 1) * sizeof(*zap_to));
+    memset((void*)home_dist, 0, maze_h * (maze_w + 1) * sizeof(*home_dist));
+    route_level = 0;
+    maze_glyph =
+        (uint16_t*)malloc(maze_h * (maze_w + 1) * sizeof(*maze_glyph));
+    if (!maze_glyph) {
+        perror("malloc");
+        exit(1);
+    }
+    memset((void*)maze_glyph, 0, maze_h * (maze_w + 1) * sizeof(*maze_glyph));
+    pellet_cell =
+        (uint64_t*)malloc(maze_h * CELL_WORDS * sizeof(*pellet_cell));
+    if (!pellet_cell) {
+        perror("malloc");
+        exit(1);
+    }
+    memset((void*)pellet_cell, 0, maze_h * CELL_WORDS * sizeof(*pellet_cell));
+    glyph_level = 0;
+    sprite_cells =
+        (uint64_t*)malloc(maze_h * (maze_w + 1) * sizeof(*sprite_cells));
+    if (!sprite_cells) {
+        perror("malloc");
+        exit(1);
+    }
+    memset((void*)sprite_cells, 0,
+           maze_h * (maze_w + 1) * sizeof(*sprite_cells));
+
+    CLEAN_ALL();
+}
+
 /**
  * @brief Export maze data as C source code
  *
@@ -296,6 +535,65 @@ void writemaze(const char* mazefile) {
     printf(";\n");
 }
 
+/**
+ * @brief Write the loaded maze as a compiled .gmz file
+ *
+ * The binary counterpart of writemaze(): stores maze_n, maze_w,
+ * maze_h, maze_flags, maze_args and the maze and maze_color planes
+ * exactly as readmaze() left them, so readmaze() can later map the
+ * file instead of parsing it. Call before the game has changed maze.
+ *
+ * @param gmzfile Path of the .gmz file to create
+ *
+ * @return 0 on success, 1 on error
+ *
+ * @see readmaze, writemaze
+ */
+int writemaze_gmz(const char* gmzfile) {
+    static const char zeros[GMZ_ALIGN];
+    gmz_header_t      hdr;
+    FILE*             outfile;
+    size_t            planes, pad;
+    int               ok;
+
+    planes = (size_t)maze_n * maze_h * (maze_w + 1);
+    memset((void*)&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, GMZ_MAGIC, sizeof(hdr.magic));
+    hdr.version   = GMZ_VERSION;
+    hdr.order     = GMZ_ORDER;
+    hdr.n         = maze_n;
+    hdr.w         = maze_w;
+    hdr.h         = maze_h;
+    hdr.flags     = maze_flags;
+    hdr.args_off  = maze_args ? sizeof(hdr) : 0;
+    hdr.args_len  = maze_args ? (strlen(maze_args) + 1) : 0;
+    hdr.cells_off = sizeof(hdr) + hdr.args_len;
+    hdr.cells_off = (hdr.cells_off + GMZ_ALIGN - 1) / GMZ_ALIGN * GMZ_ALIGN;
+    hdr.color_off = hdr.cells_off + planes;
+    hdr.color_off = (hdr.color_off + GMZ_ALIGN - 1) / GMZ_ALIGN * GMZ_ALIGN;
+    outfile       = fopen(gmzfile, "wb");
+    if (!outfile) {
+        perror(gmzfile);
+        return 1;
+    }
+    pad = hdr.cells_off - sizeof(hdr) - hdr.args_len;
+    ok  = (fwrite((void*)&hdr, sizeof(hdr), 1, outfile) == 1) &&
+         ((!maze_args) ||
+          (fwrite((void*)maze_args, hdr.args_len, 1, outfile) == 1)) &&
+         (fwrite((void*)zeros, 1, pad, outfile) == pad) &&
+         (fwrite((void*)maze, 1, planes, outfile) == planes);
+    pad = hdr.color_off - hdr.cells_off - planes;
+    ok  = ok && (fwrite((void*)zeros, 1, pad, outfile) == pad) &&
+         (fwrite((void*)maze_color, 1, planes, outfile) == planes);
+    if (fclose(outfile))
+        ok = 0;
+    if (!ok) {
+        perror(gmzfile);
+        return 1;
+    }
+    return 0;
+}
+
 /**
  * @brief Parse maze metadata arguments from file header
  *
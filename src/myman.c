@@ -40,6 +40,7 @@
 
 #include "globals.h"
 #include "utils.h"
+#include "game_context_aliases.h"
 #include <curses.h>
 #include <langinfo.h>
 
@@ -71,6 +72,8 @@
 /* resize handler */
 static volatile int got_sigwinch = 0;
 
+#ifndef MYMAN_NO_MAIN
+/* installed by myman() */
 static void (*old_sigwinch_handler)(int);
 
 static void sigwinch_handler(int signum) {
@@ -78,6 +81,7 @@ static void sigwinch_handler(int signum) {
         got_sigwinch = 1;
     }
 }
+#endif /* !defined(MYMAN_NO_MAIN) */
 
 /* Terminal and keyboard constants */
 #define CRLF "\r\n"
@@ -160,8 +164,8 @@ static const char SPRITEFILE_str[] = SPRITEFILE;
 /* mapping from CP437 to VT-100 altcharset */
 static chtype altcharset_cp437[256];
 
-/* mapping from CP437 to ASCII */
-static chtype ascii_cp437[256];
+/* mapping from CP437 to ASCII (also read by vt.c) */
+chtype ascii_cp437[256];
 
 /* USE_WCWIDTH: Enable wcwidth() for character width detection (needed for
  * CJK/wide chars) */
@@ -212,7 +216,7 @@ static int my_wcwidth(wchar_t wc) {
 
 #endif
 
-static void init_trans(int use_bullet_for_dots) {
+void init_trans(int use_bullet_for_dots) {
     int i;
 
     for (i = 0; i < 256; i++)
@@ -671,7 +675,6 @@ int use_sound             = 0;
 /* Control flow variables (not settings) */
 static int quit_requested   = 0;
 int        reinit_requested = 0; /* Exported to other modules */
-int        xoff_received    = 0;
 
 #define MY_COLS (COLS / (use_fullwidth ? 2 : 1))
 
@@ -1170,7 +1173,8 @@ static void init_pen(void) {
 
 /* wrappers around some curses functions to allow raw CP437-mode and
  * snapshots; note that these wrappers support only a small subset of
- * the corresponding curses behavior */
+ * the corresponding curses behavior. snapshot files are left to stdio
+ * buffering and flushed once, when my_refresh() closes them */
 
 FILE*  snapshot              = NULL;
 FILE*  snapshot_txt          = NULL;
@@ -1259,7 +1263,6 @@ static void snapshot_attrset_active(chtype attrs) {
         }
 #endif
     }
-    fflush(snapshot);
 }
 
 /* non-outputting version of snapshot_attrset */
@@ -1390,11 +1393,15 @@ static int my_erase(void) {
         int ret;
 
         ret = erase();
+        screen_fb_wipe();
         return ret;
     }
 }
 
 static int my_refresh(void) {
+    if (vt_active) {
+        return vt_flush();
+    }
     if (snapshot) {
         snapshot_attrset_active(0);
         fprintf(snapshot, CRLF "</font></pre></body></html>" CRLF);
@@ -1417,47 +1424,69 @@ static int my_refresh(void) {
         last_valid_col  = COLS - 1;
         last_valid_line = LINES - 1;
     }
+    if (vt_stale) {
+        /* vt_flush() drew behind curses' back */
+        clearok(curscr, TRUE);
+        vt_stale = 0;
+    }
     return refresh();
 }
 
+/* scroll screen lines top to bot up by n (down if n is negative), with
+ * the framebuffer following along */
+static int my_scroll(int top, int bot, int n) {
+    int ret = OK;
+
+    if (vt_active) {
+        vt_scroll(top, bot, n);
+    } else {
+        scrollok(stdscr, TRUE);
+        if ((setscrreg(top, bot) == ERR) || (scrl(n) == ERR))
+            ret = ERR;
+        setscrreg(0, LINES - 1);
+        scrollok(stdscr, FALSE);
+    }
+    if (ret != ERR)
+        screen_fb_scroll(top, bot, n);
+    return ret;
+}
+
 static void my_move(int y, int x) {
     if ((y < 0) || (x < 0) || (y > LINES) || (x > COLS)) {
         return;
     }
+    if (vt_active) {
+        vt_move(y, x);
+        return;
+    }
     if ((snapshot || snapshot_txt) &&
         ((x != snapshot_x) || (y != snapshot_y))) {
         snapshot_attrset_active(0);
         if ((snapshot || snapshot_txt) && (y < snapshot_y)) {
             if (snapshot) {
                 fprintf(snapshot, "<!-- cuu%d -->", snapshot_y - y);
-                fflush(snapshot);
             }
             snapshot_y = y;
         }
         if (snapshot && (x < snapshot_x) && (y == snapshot_y)) {
             fprintf(snapshot, "<!-- cub%d -->", snapshot_x - x);
-            fflush(snapshot);
         }
         while ((y > snapshot_y) || (x < snapshot_x)) {
             snapshot_y++;
             snapshot_x = 0;
             if (snapshot) {
                 fprintf(snapshot, CRLF);
-                fflush(snapshot);
             }
             if (snapshot_txt) {
                 fprintf(snapshot_txt, CRLF);
-                fflush(snapshot_txt);
             }
         }
         while (x > snapshot_x) {
             if (snapshot) {
-                fprintf(snapshot, " ");
-                fflush(snapshot);
+                fputc(' ', snapshot);
             }
             if (snapshot_txt) {
-                fprintf(snapshot_txt, " ");
-                fflush(snapshot_txt);
+                fputc(' ', snapshot_txt);
             }
             snapshot_x++;
         }
@@ -1505,7 +1534,12 @@ static int my_attrset(chtype attrs) {
                                         0
 #endif
                                         : 0;
-    my_real_attrset(attrs);
+    /* cells come in long runs of one pen, so only switch at the run
+     * boundaries; asking stdscr instead of remembering the last pen
+     * stays correct after direct standout()/attrset() calls and
+     * set_term() */
+    if ((chtype)getattrs(stdscr) != attrs)
+        my_real_attrset(attrs);
     return 1;
 }
 
@@ -1979,7 +2013,6 @@ static void snapshot_addch(short inbyte) {
             } else {
                 fprintf(snapshot, "&#%lu;", codepoint);
             }
-            fflush(snapshot);
         }
         if (snapshot_txt) {
 #ifdef A_BOLD
@@ -1999,16 +2032,27 @@ static void snapshot_addch(short inbyte) {
             }
 #endif
             fputc_utf8(codepoint, snapshot_txt);
-            fflush(snapshot_txt);
         }
         snapshot_x++;
     }
 }
 
+/* when set, my_getch() takes keys from here instead of from curses;
+ * glomph-server feeds each session from its own queue this way */
+int (*getch_hook)(void) = NULL;
+
 /* non-blocking version of getch(); return a single character if it is
  * available, ERR otherwise */
 static int my_getch(void) {
     int k = ERR;
+
+    /* a replay supplies its own keys through replay_input() */
+    if (replay_stream) {
+        return k;
+    }
+    if (getch_hook) {
+        return getch_hook();
+    }
 #if !HAVE_NODELAY
     {
         int avail = 1;
@@ -2025,19 +2069,40 @@ static int my_getch(void) {
     return k;
 }
 
+/* number of cells drawn through my_addch(), reported by glomph-bench */
+unsigned long cells_rendered = 0;
+
+/* number of frames gamerender() drew in full, reported by glomph-server */
+unsigned long full_repaints = 0;
+
 /* add CP437 byte b with attributes attrs */
 static int my_addch(unsigned long b, chtype attrs) {
     int    ret = 0;
     chtype c   = '\?';
     int    old_y, old_x;
     int    new_y, new_x;
+    int    fb_y, fb_x, fb_check = 0;
 
     if (!b)
         b = ' ';
+    cells_rendered++;
+    if (vt_active)
+        return vt_addch(b, attrs);
     getyx(stdscr, old_y, old_x);
     if ((old_y == last_valid_line) && (old_x == (last_valid_col + 1))) {
         last_valid_col += CJK_MODE ? 2 : 1;
     }
+    fb_y = old_y;
+    fb_x = old_x;
+    if (snapshot || snapshot_txt || location_is_suspect || CJK_MODE ||
+        ((fb_x + 1) >= COLS)) {
+        screen_fb_forget(fb_y, fb_x, CJK_MODE ? 2 : 1);
+    } else if (screen_fb_put(fb_y, fb_x, b, attrs)) {
+        move(fb_y, fb_x + 1);
+        return OK;
+    } else {
+        fb_check = 1;
+    }
     my_attrset(attrs);
     snapshot_addch(b);
     if (CJK_MODE && !(use_acs && use_raw && use_raw_ucs)) {
@@ -2184,6 +2249,12 @@ static int my_addch(unsigned long b, chtype attrs) {
             }
         }
     } while (0);
+    if (fb_check) {
+        /* only single-column writes can be skipped next time */
+        getyx(stdscr, new_y, new_x);
+        if ((new_y != fb_y) || (new_x != (fb_x + 1)))
+            screen_fb_forget(fb_y, fb_x, 1);
+    }
     return ret;
 }
 
@@ -2193,12 +2264,18 @@ static int my_addstr(const char* s, chtype attrs) {
     int    ret = 0;
     int    y, x;
 
-    getyx(stdscr, y, x);
+    if (vt_active)
+        vt_getyx(&y, &x);
+    else
+        getyx(stdscr, y, x);
     for (i = 0; s[i]; i++) {
         unsigned long b;
 
         b = (unsigned long)(unsigned char)s[i];
-        move(y, x + i * (CJK_MODE ? 2 : 1));
+        if (vt_active)
+            vt_move(y, x + (int)i);
+        else
+            move(y, x + i * (CJK_MODE ? 2 : 1));
         ret = my_addch(b, attrs);
         if (ret == ERR) {
             break;
@@ -2235,6 +2312,93 @@ int pager_arrow_magic = 0;
 #define PAGER_A_STANDOUT ((use_color) ? pen[PAUSE_COLOR] : PAGER_A_REVERSE)
 #endif
 
+/* Shared toggle helper functions - eliminate code duplication between pager()
+ * and gameinput() */
+
+static void toggle_color_mode(void) {
+    use_color   = !use_color;
+    use_color_p = 1;
+    if (use_color)
+        init_pen();
+    else
+        destroy_pen();
+    my_attrset(0);
+    my_clear();
+    clearok(curscr, TRUE);
+    DIRTY_ALL();
+    ignore_delay = 1;
+    frameskip    = 0;
+}
+
+static void toggle_dim_and_bright(void) {
+    use_dim_and_bright   = !use_dim_and_bright;
+    use_dim_and_bright_p = 1;
+    if (use_color) {
+        destroy_pen();
+        init_pen();
+    }
+    my_attrset(0);
+    my_clear();
+    clearok(curscr, TRUE);
+    DIRTY_ALL();
+    ignore_delay = 1;
+    frameskip    = 0;
+}
+
+static void toggle_acs_mode(void) {
+    use_acs   = !use_acs;
+    use_acs_p = 1;
+    my_clear();
+    clearok(curscr, TRUE);
+    DIRTY_ALL();
+    ignore_delay = 1;
+    frameskip    = 0;
+}
+
+static void toggle_raw_mode(void) {
+    use_raw = !use_raw;
+    my_clear();
+    clearok(curscr, TRUE);
+    DIRTY_ALL();
+    ignore_delay = 1;
+    frameskip    = 0;
+}
+
+static void toggle_underline_mode(void) {
+    use_underline = !use_underline;
+    my_clear();
+    clearok(curscr, TRUE);
+    DIRTY_ALL();
+    ignore_delay = 1;
+    frameskip    = 0;
+}
+
+static void toggle_bullet_mode(void) {
+    use_bullet_for_dots   = !use_bullet_for_dots;
+    use_bullet_for_dots_p = 1;
+    init_trans(use_bullet_for_dots);
+    my_clear();
+    clearok(curscr, TRUE);
+    DIRTY_ALL();
+    ignore_delay = 1;
+    frameskip    = 0;
+}
+
+static void toggle_sound_mode(void) {
+    use_sound = !use_sound;
+}
+
+#ifndef MYMAN_NO_MAIN
+/* the pager is only shown by myman() and myman_replay() */
+static void toggle_raw_ucs_mode(void) {
+    use_raw_ucs = !use_raw_ucs;
+    my_clear();
+    clearok(curscr, TRUE);
+    DIRTY_ALL();
+    ignore_delay = 1;
+    frameskip    = 0;
+}
+
 static void pager_move(int y, int x) {
     my_move((pager_big ? ((y)*pager_tile_h) : y),
             ((pager_big ? ((x)*tile_w) : x) * (use_fullwidth ? 2 : 1)));
@@ -2333,91 +2497,6 @@ static void pager_addstr(const char* s, chtype a) {
     }
 }
 
-/* Shared toggle helper functions - eliminate code duplication between pager()
- * and gameinput() */
-
-static void toggle_color_mode(void) {
-    use_color   = !use_color;
-    use_color_p = 1;
-    if (use_color)
-        init_pen();
-    else
-        destroy_pen();
-    my_attrset(0);
-    my_clear();
-    clearok(curscr, TRUE);
-    DIRTY_ALL();
-    ignore_delay = 1;
-    frameskip    = 0;
-}
-
-static void toggle_dim_and_bright(void) {
-    use_dim_and_bright   = !use_dim_and_bright;
-    use_dim_and_bright_p = 1;
-    if (use_color) {
-        destroy_pen();
-        init_pen();
-    }
-    my_attrset(0);
-    my_clear();
-    clearok(curscr, TRUE);
-    DIRTY_ALL();
-    ignore_delay = 1;
-    frameskip    = 0;
-}
-
-static void toggle_acs_mode(void) {
-    use_acs   = !use_acs;
-    use_acs_p = 1;
-    my_clear();
-    clearok(curscr, TRUE);
-    DIRTY_ALL();
-    ignore_delay = 1;
-    frameskip    = 0;
-}
-
-static void toggle_raw_mode(void) {
-    use_raw = !use_raw;
-    my_clear();
-    clearok(curscr, TRUE);
-    DIRTY_ALL();
-    ignore_delay = 1;
-    frameskip    = 0;
-}
-
-static void toggle_raw_ucs_mode(void) {
-    use_raw_ucs = !use_raw_ucs;
-    my_clear();
-    clearok(curscr, TRUE);
-    DIRTY_ALL();
-    ignore_delay = 1;
-    frameskip    = 0;
-}
-
-static void toggle_underline_mode(void) {
-    use_underline = !use_underline;
-    my_clear();
-    clearok(curscr, TRUE);
-    DIRTY_ALL();
-    ignore_delay = 1;
-    frameskip    = 0;
-}
-
-static void toggle_bullet_mode(void) {
-    use_bullet_for_dots   = !use_bullet_for_dots;
-    use_bullet_for_dots_p = 1;
-    init_trans(use_bullet_for_dots);
-    my_clear();
-    clearok(curscr, TRUE);
-    DIRTY_ALL();
-    ignore_delay = 1;
-    frameskip    = 0;
-}
-
-static void toggle_sound_mode(void) {
-    use_sound = !use_sound;
-}
-
 static void pager(void) {
     int c = ERR;
     int k = ERR;
@@ -2614,7 +2693,7 @@ static void pager(void) {
                     }
                     my_refresh();
                     do {
-                        while ((k = my_getch()) == ERR) {
+                        while ((k = replay_input(my_getch())) == ERR) {
                             my_refresh();
                             if (got_sigwinch)
                                 break;
@@ -2775,7 +2854,7 @@ static void pager(void) {
                 }
             }
             my_refresh();
-            while ((k = my_getch()) == ERR) {
+            while ((k = replay_input(my_getch())) == ERR) {
                 my_refresh();
                 if (got_sigwinch)
                     break;
@@ -2895,8 +2974,8 @@ static void pager(void) {
         debug_pager = 0;
     }
 }
+#endif /* !defined(MYMAN_NO_MAIN) */
 
-int key_buffer     = ERR;
 int key_buffer_ERR = ERR;
 
 double td = 0.0L;
@@ -2904,6 +2983,65 @@ double td = 0.0L;
 static int sdl_audio_open = 0;
 #endif
 
+/* Helper: Mark dirty the maze cells drawn on screen lines that show
+ * maze pixels p0 to p1 along the screen's lines */
+static void mark_viewport_lines(int p0, int p1) {
+    if (reflect)
+        mark_rect(XTILE(p0), 0, XTILE(p1), maze_h - 1);
+    else
+        mark_rect(0, YTILE(p0), maze_w, YTILE(p1));
+}
+
+/* Helper: When the viewport only moved along the screen lines and the
+ * maze fills the screen's width, scroll the maze lines in hardware and
+ * mark the lines it exposed dirty, so the render pass need not repaint
+ * the rest; returns nonzero if it scrolled.  The last line is left out
+ * of the region since the status line and the bonus message are drawn
+ * there over the maze */
+static int scroll_viewport(int x1, int y1, int r_off, int c_off) {
+    int  major, n, top, bot, end;
+    long major0, minor0;
+
+    if (all_dirty || winning || paused || debug || (!(use_idlok || vt_active)))
+        return 0;
+    major  = reflect ? x1 : y1;
+    major0 = reflect ? scroll_offset_x0 : scroll_offset_y0;
+    minor0 = reflect ? scroll_offset_y0 : scroll_offset_x0;
+    n      = major - (int)major0;
+    if ((!n) || ((reflect ? y1 : x1) != minor0) || (reflect ? r_off : c_off) ||
+        ((reflect ? (gfx_h * maze_h) : (gfx_w * maze_w)) < MY_COLS))
+        return 0;
+    top = reflect ? c_off : r_off;
+    end = MIN(LINES, top + (reflect ? (gfx_w * maze_w) : (gfx_h * maze_h)));
+    bot = MIN(end, LINES - 1) - 1;
+    if (((n > 0) ? n : -n) > (bot - top))
+        return 0;
+    if (my_scroll(top, bot, n) == ERR)
+        return 0;
+    /* screen line y shows maze pixel y - top + major */
+    if (n > 0) {
+        mark_viewport_lines(bot + 1 - n - top + major, end - 1 - top + major);
+    } else {
+        mark_viewport_lines(major, major - n - 1);
+        if (bot + 1 < end)
+            mark_viewport_lines(bot + 1 - top + major, end - 1 - top + major);
+    }
+    /* the viewport may stop one line past the maze, which has no cells
+     * to mark, so blank that line the way a full repaint would */
+    if ((end - 1 - top + major) >=
+        (reflect ? (gfx_w * maze_w) : (gfx_h * maze_h))) {
+        int x;
+
+        for (x = 0;
+             x < MIN(MY_COLS, (reflect ? (gfx_h * maze_h) : (gfx_w * maze_w)));
+             x++) {
+            my_move(end - 1, x * (use_fullwidth ? 2 : 1));
+            my_addch(' ', 0);
+        }
+    }
+    return 1;
+}
+
 /**
  * @brief Handle game sound effects playback
  *
@@ -2917,10 +3055,13 @@ static int sdl_audio_open = 0;
  * intermission, level, bonus, siren (multiple levels).
  *
  * @note Clears myman_sfx flags after handling
+ * @param ctx Session whose sound requests to play; becomes the current
+ *            context
+ *
  * @note Respects use_sound setting and mutes in demo mode
  * @see myman_sfx flags, USE_SDL_MIXER, USE_BEEP
  */
-void gamesfx(void) {
+void gamesfx(game_context_t* ctx) {
 #if USE_SDL_MIXER
 #define handle_sfx(n)                                                          \
     do {                                                                       \
@@ -2959,6 +3100,7 @@ void gamesfx(void) {
     } while (0)
 #endif
 #endif
+    game_ctx = ctx;
     handle_sfx(credit);
     handle_sfx(dot);
     handle_sfx(dying);
@@ -2994,6 +3136,129 @@ static void mark_all_dirty_sprites(void) {
     }
 }
 
+#if SPRITE_REGISTERS > 64
+#error "sprite_cells holds one bit per sprite register"
+#endif
+
+/* Helper: Bucket the used sprite registers by the maze cells they can
+ * draw on (one bit per register in sprite_cells), so the render pass
+ * only tests those; returns the mask of every used register for
+ * pixels outside the maze */
+static uint64_t bucket_sprites(void) {
+    uint64_t all = 0;
+
+    memset((void*)sprite_cells, 0,
+           maze_h * (maze_w + 1) * sizeof(*sprite_cells));
+    for (int s = 0; s < SPRITE_REGISTERS; s++) {
+        int x0, x1, y0, y1, xtile, ytile;
+
+        if (!sprite_register_used[s])
+            continue;
+        all |= (uint64_t)1 << s;
+        /* union of the sprite, the tile-drawn sprite and the debug
+         * marker at the register's own position */
+        x0 = MIN(sprite_register_x[s] - MAX(sgfx_w, gfx_w) / 2,
+                 sprite_register_x[s]);
+        x1 = MAX(sprite_register_x[s] - sgfx_w / 2 + sgfx_w,
+                 sprite_register_x[s] - gfx_w / 2 + gfx_w) -
+             1;
+        y0 = MIN(sprite_register_y[s] - MAX(sgfx_h, gfx_h) / 2,
+                 sprite_register_y[s]);
+        y1 = MAX(sprite_register_y[s] - sgfx_h / 2 + sgfx_h,
+                 sprite_register_y[s] - gfx_h / 2 + gfx_h) -
+             1;
+        if ((x1 < 0) || (y1 < 0))
+            continue;
+        x0 = XTILE(MAX(x0, 0));
+        y0 = YTILE(MAX(y0, 0));
+        x1 = MIN(XTILE(x1), maze_w);
+        y1 = MIN(YTILE(y1), maze_h - 1);
+        for (ytile = y0; ytile <= y1; ytile++)
+            for (xtile = x0; xtile <= x1; xtile++)
+                sprite_cells[ytile * (maze_w + 1) + xtile] |= (uint64_t)1
+                                                              << s;
+    }
+    return all;
+}
+
+/* index of the lowest set bit of a nonzero word */
+static int lowest_bit(uint64_t w) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(w);
+#else
+    int n = 0;
+
+    while (!(w & 1)) {
+        w >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static uint64_t* scan_cell      = NULL;
+static size_t    scan_cell_size = 0;
+
+/* Helper: Collect the cells the render pass has to visit (dirty or
+ * holding a pellet) into scan_cell, one row of bits per maze tile along
+ * a screen line: maze rows, or maze columns when reflected. Returns
+ * the number of words per row */
+static int scan_cells(void) {
+    int    words = reflect ? ((maze_h + 63) >> 6) : CELL_WORDS;
+    size_t size  = (size_t)(reflect ? (maze_w + 1) : maze_h) * words;
+    int    y, w;
+
+    if (size > scan_cell_size) {
+        free((void*)scan_cell);
+        scan_cell = (uint64_t*)malloc(size * sizeof(*scan_cell));
+        if (!scan_cell) {
+            perror("malloc");
+            exit(1);
+        }
+        scan_cell_size = size;
+    }
+    if (!reflect) {
+        for (w = 0; w < maze_h * CELL_WORDS; w++)
+            scan_cell[w] = dirty_cell[w] | pellet_cell[w];
+        return words;
+    }
+    memset((void*)scan_cell, 0, size * sizeof(*scan_cell));
+    for (y = 0; y < maze_h; y++)
+        for (w = 0; w < CELL_WORDS; w++) {
+            uint64_t bits = dirty_cell[y * CELL_WORDS + w] |
+                            pellet_cell[y * CELL_WORDS + w];
+
+            while (bits) {
+                int x = (w << 6) + lowest_bit(bits);
+
+                bits &= bits - 1;
+                scan_cell[x * words + (y >> 6)] |= (uint64_t)1 << (y & 63);
+            }
+        }
+    return words;
+}
+
+/* Helper: First pixel column at or after vcol, and before limit, on a
+ * maze line whose tile ((vcol + off) / size) has its bit set in the
+ * scan_cell row; limit if there is none */
+static int next_scan_vcol(const uint64_t* row, int words, int vcol, int off,
+                          int size, int limit) {
+    int      m = (vcol + off) / size;
+    int      w = m >> 6;
+    uint64_t bits;
+
+    if ((vcol >= limit) || (w >= words))
+        return limit;
+    bits = row[w] & (~(uint64_t)0 << (m & 63));
+    while (!bits) {
+        if (++w >= words)
+            return limit;
+        bits = row[w];
+    }
+    m = (w << 6) + lowest_bit(bits);
+    return MIN(MAX(vcol, m * size - off), limit);
+}
+
 /* Helper: Calculate viewport offset to center on player
  * Returns offsets for row and column positioning */
 static void calculate_viewport_offset(int* x1_out, int* y1_out, int* r_off_out,
@@ -3053,19 +3318,51 @@ static void calculate_viewport_offset(int* x1_out, int* y1_out, int* r_off_out,
     *c_off_out = c_off;
 }
 
-void gamerender(void) {
-    int  i, j;
-    long c = 0;
-    int  x1, y1;
-    int  r_off, c_off;
-    int  line, col;
-    int  vline, vcol;
-    int  pause_shown;
+void gamerender(game_context_t* ctx) {
+    int      i, j;
+    long     c = 0;
+    int      x1, y1;
+    int      r_off, c_off;
+    int      line, col;
+    int      vline, vcol;
+    int      pause_shown;
+    int      fb_ok, hw_scrolled;
+    uint64_t sprites_all;
+    int      scan_words;
+    int      scan_off, scan_size, scan_end;
+
+    const uint64_t* scan_row;
+
+    game_ctx = ctx;
 
     pause_shown = 0;
+    if (vt_backend &&
+        !(snapshot || snapshot_txt || location_is_suspect || CJK_MODE))
+        vt_begin();
+    /* the status area is cleaned up cell by cell, and the maze scrolled
+     * in hardware, only while the framebuffer knows what the screen
+     * shows */
+    fb_ok = screen_fb_frame() &&
+            !(snapshot || snapshot_txt || location_is_suspect || CJK_MODE);
+    if (!fb_ok) {
+        if (status_dirty)
+            DIRTY_ALL();
+        status_dirty = 0;
+    }
     mark_all_dirty_sprites();
     if (snapshot || snapshot_txt || all_dirty) {
-        my_erase();
+        full_repaints++;
+        /* a full repaint only sends the cells that changed, unless a
+         * snapshot needs my_erase() or the framebuffer is out of date */
+        if (snapshot || snapshot_txt || location_is_suspect || CJK_MODE ||
+            !screen_fb_erase()) {
+            if (vt_active) {
+                vt_clear();
+                screen_fb_wipe();
+            } else {
+                my_erase();
+            }
+        }
         DIRTY_ALL();
         ignore_delay = 1;
         frameskip    = 0;
@@ -3076,6 +3373,12 @@ void gamerender(void) {
     (reflect ? my_move((x), (y) * (use_fullwidth ? 2 : 1))                     \
              : my_move((y), (x) * (use_fullwidth ? 2 : 1)))
     calculate_viewport_offset(&x1, &y1, &r_off, &c_off);
+    hw_scrolled = fb_ok && scroll_viewport(x1, y1, r_off, c_off);
+    maze_glyphs();
+    sprites_all = bucket_sprites();
+    /* unless everything is redrawn, maze lines only visit the pixels of
+     * dirty and pellet cells */
+    scan_words = (all_dirty || winning || paused) ? 0 : scan_cells();
     standend();
 #if HAVE_ATTRSET
     attrset(0);
@@ -3098,7 +3401,9 @@ void gamerender(void) {
                 int    filler_tile = 0;
                 chtype a           = 0;
 
-                if (snapshot || snapshot_txt || all_dirty) {
+                /* a status area cleanup repaints the spaces here too,
+                 * so only cells beside the maze are left to sweep */
+                if (snapshot || snapshot_txt || all_dirty || status_dirty) {
                     filler_tile = ' ';
                 }
 
@@ -3209,6 +3514,9 @@ void gamerender(void) {
                             a = TEXT_COLOR;
                         a = pen[a];
                     }
+                    /* only digits and markers belong to the status
+                     * area, the spaces of a full repaint do not */
+                    screen_fb_status(filler_tile != ' ');
                     my_move(vline + (reflect ? c_off : r_off),
                             (vcol + (reflect ? r_off : c_off)) *
                                 (use_fullwidth ? 2 : 1));
@@ -3220,8 +3528,10 @@ void gamerender(void) {
                         a);
                 }
             }
+            screen_fb_status(0);
             continue;
         }
+        screen_fb_status(1);
         if (((reflect ? c_off : r_off) < tile_h) &&
             ((reflect ? r_off : c_off) >= (5 * tile_w)) && (vline < tile_h) &&
             (!intermission_running)) {
@@ -3321,9 +3631,31 @@ void gamerender(void) {
                 }
             }
         }
-        for (vcol = 0; (vcol < MY_COLS) &&
-                       (vcol < (reflect ? (gfx_h * maze_h) : (gfx_w * maze_w)));
-             vcol++) {
+        screen_fb_status(0);
+        {
+            int major;
+
+            /* scrolling can call DIRTY_ALL() at pixel (0, 0), so that
+             * pixel is always visited and later lines check again */
+            scan_row = NULL;
+            major    = reflect ? XTILE(vline + x1) : YTILE(vline + y1);
+            if (scan_words && (!all_dirty) &&
+                (major < (reflect ? (maze_w + 1) : maze_h)))
+                scan_row = scan_cell + major * scan_words;
+            scan_off  = reflect ? y1 : x1;
+            scan_size = reflect ? gfx_h : gfx_w;
+            scan_end =
+                MIN(MY_COLS, (reflect ? (gfx_h * maze_h) : (gfx_w * maze_w)));
+        }
+        for (vcol = (scan_row && vline) ? next_scan_vcol(scan_row, scan_words,
+                                                          0, scan_off,
+                                                          scan_size, scan_end)
+                                        : 0;
+             vcol < scan_end;
+             vcol = (scan_row && !all_dirty)
+                        ? next_scan_vcol(scan_row, scan_words, vcol + 1,
+                                         scan_off, scan_size, scan_end)
+                        : (vcol + 1)) {
             int    xtile, ytile;
             int    x_off, y_off;
             int    s;
@@ -3363,7 +3695,7 @@ void gamerender(void) {
                     }
                     scrolling = nscrolling;
                 }
-                if (scrolling) {
+                if (scrolling && !hw_scrolled) {
                     DIRTY_ALL();
                 }
             }
@@ -3417,9 +3749,16 @@ void gamerender(void) {
                                   xtile]) ||
                 winning) {
                 if (!c) {
-                    for (s = 0; s < SPRITE_REGISTERS; s++) {
+                    uint64_t here;
+
+                    here = ((ytile < maze_h) && (xtile <= maze_w))
+                               ? sprite_cells[ytile * (maze_w + 1) + xtile]
+                               : sprites_all;
+                    for (s = 0; (s < SPRITE_REGISTERS) && (here >> s); s++) {
                         int t, x, y, iseyes;
 
+                        if (!((here >> s) & 1))
+                            continue;
                         t = ((unsigned)sprite_register[s]) +
                             ((sprite_register_frame[s] < 0)
                                  ? (-sprite_register_frame[s])
@@ -3535,29 +3874,14 @@ void gamerender(void) {
                     }
                 }
                 if ((!c) && (ytile < maze_h) && (xtile < maze_w)) {
-                    c = maze_visual(maze_level, ytile, xtile);
+                    unsigned glyph;
+
+                    glyph = maze_glyph[ytile * (maze_w + 1) + xtile];
+                    c     = glyph & 0xff;
                     {
                         int c_mapped;
 
-                        c_mapped = c;
-                        if (c_mapped == ':') {
-                            c_mapped = ' ';
-                        } else if (c_mapped == 'l') {
-                            c_mapped = 179;
-                        } else if (c_mapped == '~') {
-                            c_mapped = 196;
-                        } else if ((c_mapped == 'o') &&
-                                   (!tile_used[c_mapped])) {
-                            c_mapped = 254;
-                        }
-                        while (
-                            (!tile_used[c_mapped]) &&
-                            (((int)(unsigned)fallback_cp437[c_mapped]) != c) &&
-                            (((int)(unsigned)fallback_cp437[c_mapped]) !=
-                             c_mapped)) {
-                            c_mapped = (unsigned long)(unsigned char)
-                                fallback_cp437[c_mapped];
-                        }
+                        c_mapped = glyph >> 8;
                         if (tile_used[c_mapped]) {
                             if ((ISWALL(c) && !ISDOOR(c)) || (c == ' ')) {
                                 is_wall = 1;
@@ -3595,12 +3919,9 @@ void gamerender(void) {
 #endif
                             }
                             if (debug) {
-                                int           s = WHOSE_HOME_DIR(ytile, xtile);
-                                unsigned char d;
+                                int d;
 
-                                d = home_dir[(s % ghosts * maze_h + ytile) *
-                                                 (maze_w + 1) +
-                                             xtile];
+                                d = find_home_dir(ytile, xtile);
                                 c = (((unsigned)d) == MYMAN_UP)      ? '^'
                                     : (((unsigned)d) == MYMAN_DOWN)  ? 'v'
                                     : (((unsigned)d) == MYMAN_LEFT)  ? '<'
@@ -3610,15 +3931,8 @@ void gamerender(void) {
                                     : ISOPEN(c)                      ? ' '
                                     : ISDOOR(c)                      ? 'X'
                                                                      : '@';
-                                if (use_color && ((unsigned)d)) {
-                                    a = sprite_color
-                                        [((unsigned)
-                                              sprite_register[MEANGHOST(s)]) +
-                                         sprite_register_frame[MEANGHOST(s)]];
-                                    if (!a)
-                                        a = sprite_register_color[MEANGHOST(s)];
-                                    a = pen[a];
-                                }
+                                if (use_color && ((unsigned)d))
+                                    a = pen[0xF];
                             } else {
                                 if ((ISPELLET(c) &&
                                      ((cycles / MYMANFIFTH) & 4) && (!dead) &&
@@ -3753,6 +4067,8 @@ void gamerender(void) {
             int hud_level_anchor;
             int hud_level_anchor2;
 
+            screen_fb_status(1);
+
             hud_line =
                 vline + sprite_h -
                 ((LINES > (reflect ? (gfx_w * maze_w) : (gfx_h * maze_h)))
@@ -3794,6 +4110,7 @@ void gamerender(void) {
                     }
                 }
             }
+            screen_fb_status(0);
         }
     }
     if (LINES >= ((reflect ? c_off : r_off) +
@@ -3819,6 +4136,7 @@ void gamerender(void) {
                 2 * tile_w)) {
             life_anchor -= sprite_w;
         }
+        screen_fb_status(1);
         for (line = 0; line < sprite_h; line++) {
             for (col = 0; col < MY_COLS; col++) {
                 if ((col - (reflect ? r_off : c_off) >= (2 * tile_w)) &&
@@ -3890,6 +4208,7 @@ void gamerender(void) {
                 }
             }
         }
+        screen_fb_status(0);
     }
     my_attrset(0);
     if (debug) {
@@ -3928,13 +4247,25 @@ void gamerender(void) {
         my_move(LINES - 1, (MY_COLS - 46) * (use_fullwidth ? 2 : 1));
         my_addstr(buf, 0);
     }
-    if (paused && !(snapshot || snapshot_txt || pause_shown)) {
+    if (paused && vt_active && !pause_shown) {
+        my_move(LINES / 2, (COLS - (int)strlen(PAUSE)) / 2);
+        my_addstr(PAUSE, A_STANDOUT);
+    } else if (paused && !(snapshot || snapshot_txt || pause_shown)) {
         standout();
         mvprintw(LINES / 2,
                  ((COLS - (int)strlen(PAUSE)) & ~(use_fullwidth ? 1 : 0)) / 2,
                  PAUSE);
         standend();
+        screen_fb_forget(
+            LINES / 2,
+            ((COLS - (int)strlen(PAUSE)) & ~(use_fullwidth ? 1 : 0)) / 2,
+            (int)strlen(PAUSE));
     }
+    if (status_dirty) {
+        screen_fb_status_sweep();
+        status_dirty = 0;
+    }
+    screen_fb_sweep();
     {
         int was_inverted;
 
@@ -3948,14 +4279,7 @@ void gamerender(void) {
             CLEAN_ALL();
         }
     }
-    {
-        int s;
-        for (s = 0; s < SPRITE_REGISTERS; s++) {
-            if (sprite_register_used[s]) {
-                mark_sprite_register(s);
-            }
-        }
-    }
+    mark_all_dirty_sprites();
 }
 
 /* Helper: Handle control flow keys (quit, pause, signals)
@@ -4074,7 +4398,7 @@ static int handle_settings_keys(int k) {
     return -1;
 }
 
-int gameinput(void) {
+int gameinput(game_context_t* ctx) {
     int           k;
     int           hero_can_move_left  = 0;
     int           hero_can_move_right = 0;
@@ -4083,6 +4407,8 @@ int gameinput(void) {
     unsigned char m1, m2;
     int           xtile, ytile, x_off, y_off;
 
+    game_ctx = ctx;
+
     x_off = sprite_register_x[HERO] % gfx_w;
     y_off = sprite_register_y[HERO] % gfx_h;
     xtile = XTILE(sprite_register_x[HERO]);
@@ -4101,6 +4427,7 @@ int gameinput(void) {
             ignore_delay = 1;
             frameskip    = 0;
         }
+        k = replay_input(k);
         m1 = (unsigned char)maze[(maze_level * maze_h + ytile) * (maze_w + 1) +
                                  XWRAP(xtile - NOTRIGHT(x_off))];
         m2 = (unsigned char)
@@ -4257,37 +4584,14 @@ int gameinput(void) {
     return (k == ERR) ? -1 : -2;
 }
 
-static void myman(void) {
-
-    do {
-#if USE_SDL_MIXER
-        SDL_Init(SDL_INIT_EVERYTHING);
-        if ((!sdl_audio_open) && (!Mix_OpenAudio(44100, AUDIO_S16, 1, 4096))) {
-            sdl_audio_open = 1;
-        }
-#endif
-        if (!myman_lines)
-            myman_lines = (reflect ? (maze_w * gfx_w) : (maze_h * gfx_h)) +
-                          (3 * tile_h + sprite_h);
-        if (!myman_columns)
-            myman_columns = (reflect ? (maze_h * gfx_h) : (maze_w * gfx_w)) *
-                            (use_fullwidth ? 2 : 1);
-
-#ifdef INITSCR_WITH_HINTS
-        initscrWithHints(myman_lines, myman_columns,
-                         "MyMan [" MYMAN " " MYMANVERSION "]", MYMAN);
-#else
-        {
-            if (!initscr()) {
-                perror("initscr");
-                fflush(stderr);
-                exit(1);
-            }
-#endif
-#ifdef NCURSES_VERSION
-        use_default_colors();
-#endif
-    }
+/**
+ * @brief Put the current curses screen into game mode
+ *
+ * Sets up input modes, the character translation table and the color
+ * pens for whichever screen set_term() last selected, so a driver that
+ * opens one screen per session can prepare each of them the same way.
+ */
+void myman_screen_init(void) {
     my_clear();
     cbreak();
     noecho();
@@ -4332,6 +4636,66 @@ static void myman(void) {
     }
     if (use_color)
         init_pen();
+}
+
+/**
+ * @brief Restore the current curses screen and end curses mode on it
+ */
+void myman_screen_done(void) {
+    my_attrset(0);
+#if HAVE_CURS_SET
+    curs_set(1); /* slcurses doesn't do this in endwin() */
+#endif
+    my_clear();
+    if (use_color) {
+        standout();
+        mvprintw(LINES ? 1 : 0, 0, " ");
+        standend();
+        refresh();
+        destroy_pen();
+        mvprintw(LINES ? 1 : 0, 0, " ");
+        addch('\n');
+    }
+    refresh();
+    echo();
+    endwin();
+}
+
+#ifndef MYMAN_NO_MAIN
+/* the game loop and the replay player; only main() runs them, so the
+ * tools leave them out */
+static void myman(void) {
+
+    do {
+#if USE_SDL_MIXER
+        SDL_Init(SDL_INIT_EVERYTHING);
+        if ((!sdl_audio_open) && (!Mix_OpenAudio(44100, AUDIO_S16, 1, 4096))) {
+            sdl_audio_open = 1;
+        }
+#endif
+        if (!myman_lines)
+            myman_lines = (reflect ? (maze_w * gfx_w) : (maze_h * gfx_h)) +
+                          (3 * tile_h + sprite_h);
+        if (!myman_columns)
+            myman_columns = (reflect ? (maze_h * gfx_h) : (maze_w * gfx_w)) *
+                            (use_fullwidth ? 2 : 1);
+
+#ifdef INITSCR_WITH_HINTS
+        initscrWithHints(myman_lines, myman_columns,
+                         "MyMan [" MYMAN " " MYMANVERSION "]", MYMAN);
+#else
+        {
+            if (!initscr()) {
+                perror("initscr");
+                fflush(stderr);
+                exit(1);
+            }
+#endif
+#ifdef NCURSES_VERSION
+        use_default_colors();
+#endif
+    }
+    myman_screen_init();
     old_sigwinch_handler = signal(SIGWINCH, sigwinch_handler);
     reinit_requested     = 0;
     pager();
@@ -4344,7 +4708,7 @@ static void myman(void) {
     old_showlives = 0;
     old_level     = 0;
     while (!reinit_requested) {
-        if (!gamecycle(LINES, COLS)) {
+        if (!gamecycle(&game_main, LINES, COLS)) {
             break;
         }
     }
@@ -4352,23 +4716,7 @@ static void myman(void) {
         signal(SIGWINCH, old_sigwinch_handler);
     else
         signal(SIGWINCH, SIG_DFL);
-    my_attrset(0);
-#if HAVE_CURS_SET
-    curs_set(1); /* slcurses doesn't do this in endwin() */
-#endif
-    my_clear();
-    if (use_color) {
-        standout();
-        mvprintw(LINES ? 1 : 0, 0, " ");
-        standend();
-        refresh();
-        destroy_pen();
-        mvprintw(LINES ? 1 : 0, 0, " ");
-        addch('\n');
-    }
-    refresh();
-    echo();
-    endwin();
+    myman_screen_done();
     if (reinit_requested) {
         refresh();
         {
@@ -4422,6 +4770,91 @@ while (reinit_requested)
 fprintf(stderr, "%s: scored %d points\n", progname, score);
 }
 
+/* play back a --replay recording with no pacing, drawing into an
+ * off-screen terminal (or not drawing at all with --headless); returns
+ * nonzero if the game diverged from the recorded checkpoints */
+static int myman_replay(void) {
+    headless_stats_t stats;
+    FILE*            devnull;
+    SCREEN*          screen;
+    const char*      term;
+    char             buf[32];
+    long             frames0 = frames;
+    double           t0;
+
+    /* key handlers and the pager draw even when frames are not
+     * rendered, so there is always a (discarded) screen */
+    sprintf(buf, "%d",
+            (reflect ? (maze_w * gfx_w) : (maze_h * gfx_h)) +
+                (3 * tile_h + sprite_h));
+    myman_setenv("LINES", buf);
+    sprintf(buf, "%d",
+            (reflect ? (maze_h * gfx_h) : (maze_w * gfx_w)) *
+                (use_fullwidth ? 2 : 1));
+    myman_setenv("COLUMNS", buf);
+    devnull = fopen("/dev/null", "w");
+    if (!devnull) {
+        perror("/dev/null");
+        return 1;
+    }
+    term   = myman_getenv("TERM");
+    screen = newterm((char*)((term && *term) ? term : "vt100"), devnull, stdin);
+    if (!screen)
+        screen = newterm((char*)"vt100", devnull, stdin);
+    if (!screen) {
+        fprintf(stderr, "%s: newterm failed\n", progname);
+        fclose(devnull);
+        return 1;
+    }
+    set_term(screen);
+    leaveok(stdscr, TRUE);
+    init_trans(use_bullet_for_dots);
+    vt_output(devnull);
+    mymandelay = 0;
+
+    t0 = doubletime();
+    do {
+        reinit_requested = 0;
+        pager();
+        if (!pager_notice) {
+            reinit_requested = 0;
+        }
+        while (!reinit_requested) {
+            int ret;
+
+            if (headless) {
+                gameattract(&game_main);
+                ret = gameinput(&game_main);
+                if (ret < 0) {
+                    ret = gametick(&game_main, ret, 0);
+                }
+            } else {
+                ret = gamecycle(&game_main, LINES, COLS);
+            }
+            myman_sfx = 0UL;
+            if (!ret) {
+                break;
+            }
+        }
+    } while (reinit_requested && !replay_diverged);
+    stats.ticks   = (unsigned long)(frames - frames0);
+    stats.seconds = doubletime() - t0;
+    endwin();
+    delscreen(screen);
+    vt_output(stdout);
+    fclose(devnull);
+
+    headless_report(stderr, &stats);
+    fprintf(stderr, "%s: scored %d points\n", progname, score);
+    if (replay_diverged) {
+        return 1;
+    }
+    fprintf(stderr, "%s: %lu keys replayed, %lu checkpoints verified\n",
+            progname, replay_keys, replay_checkpoints);
+    return 0;
+}
+#endif /* !defined(MYMAN_NO_MAIN) */
+
 void usage(const char* mazefile, const char* spritefile, const char* tilefile) {
     printf("Usage: %s [options]" XCURSES_USAGE "\n", progname);
     puts("-h \tdisplay this help and exit");
@@ -4467,6 +4900,15 @@ void usage(const char* mazefile, const char* spritefile, const char* tilefile) {
     puts("-x \treflect maze diagonally, exchanging the upper right and lower "
          "left corners");
     puts("-X \tdo not reflect maze");
+    puts("--headless \trun the game without a terminal as fast as possible "
+         "and report ticks/second");
+    printf("--ticks NUM \tstop --headless after NUM ticks (default %lu)\n",
+           (unsigned long)HEADLESS_TICKS);
+    puts("--record FILE \trecord keys and state checkpoints to FILE");
+    puts("--replay FILE \treplay a recording without pacing and verify its "
+         "checkpoints");
+    puts("--backend=vt \tdraw the game with direct VT/ANSI output, one "
+         "write() per frame (default curses)");
     printf("Defaults:");
     printf(use_raw ? " -r" : " -R");
     printf(use_raw_ucs ? " -e" : " -E");
@@ -4510,6 +4952,7 @@ void usage(const char* mazefile, const char* spritefile, const char* tilefile) {
 
 /* Handle display/rendering options (-r, -a, -c, -u, etc.) */
 
+#ifndef MYMAN_NO_MAIN
 int main(int argc, char* argv[], char* envp[]) {
     int  i;
     long c = 0;
@@ -4545,6 +4988,41 @@ int main(int argc, char* argv[], char* envp[]) {
     if (nogame)
         fflush(stdout), fflush(stderr), exit(0);
 
+    if (replay_path) {
+        int ret;
+
+        if (record_path) {
+            fprintf(stderr, "%s: --record and --replay are exclusive\n",
+                    progname);
+            fflush(stderr);
+            return 1;
+        }
+        if (replay_open(replay_path)) {
+            fflush(stderr);
+            return 1;
+        }
+        ret = myman_replay();
+        replay_close();
+        fflush(stdout), fflush(stderr);
+        return ret;
+    }
+    if (record_path && record_open(record_path)) {
+        fflush(stderr);
+        return 1;
+    }
+
+    if (headless) {
+        headless_stats_t stats;
+        int              ret;
+
+        ret = headless_run(&game_main, headless_ticks, &stats);
+        record_close();
+        headless_report(stderr, &stats);
+        fprintf(stderr, "%s: scored %d points\n", progname, score);
+        fflush(stdout), fflush(stderr);
+        return ret;
+    }
+
     if (!setlocale(LC_CTYPE, "")) {
         fprintf(stderr, "warning: setlocale(LC_CTYPE, \"\") failed\n");
         fflush(stderr);
@@ -4554,5 +5032,7 @@ int main(int argc, char* argv[], char* envp[]) {
         uni_cp437 = uni_cp437_fullwidth;
     }
     myman();
+    record_close();
     return 0;
 }
+#endif /* !defined(MYMAN_NO_MAIN) */
@@ -23,10 +23,24 @@
  *  DEALINGS IN THE SOFTWARE.
  */
 
+/* pthread_sigmask() and sysconf() */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "globals.h"
 #include "utils.h"
+#include "game_context_aliases.h"
+
+/* most threads paint_walls() paints levels on */
+#ifndef PAINT_MAX_JOBS
+#define PAINT_MAX_JOBS 16
+#endif
 
 /**
  * @brief Mark maze cell as needing redraw
@@ -44,11 +58,137 @@
 void mark_cell(int x, int y) {
     if ((!all_dirty) && ((((long)(x)) >= 0) && (((long)(y)) >= 0) &&
                          ((x) <= maze_w) && ((y) < maze_h))) {
-        int idx;
+        dirty_cell[y * CELL_WORDS + (x >> 6)] |= (uint64_t)1 << (x & 63);
+    }
+}
+
+/**
+ * @brief Mark a rectangle of maze cells as needing redraw
+ *
+ * Same as calling mark_cell() for every cell from (x0, y0) to (x1, y1)
+ * inclusive, but clips the rectangle once and sets each row's span in
+ * dirty_cell a whole word at a time.
+ *
+ * @param x0 Left cell X coordinate (tile units)
+ * @param y0 Top cell Y coordinate (tile units)
+ * @param x1 Right cell X coordinate (tile units, inclusive)
+ * @param y1 Bottom cell Y coordinate (tile units, inclusive)
+ *
+ * @note No-op if all_dirty is true or the rectangle misses the maze
+ * @see mark_cell, mark_sprite_register
+ */
+void mark_rect(int x0, int y0, int x1, int y1) {
+    int      y, w, w0, w1;
+    uint64_t m0, m1;
+
+    if (all_dirty)
+        return;
+    x0 = MAX(x0, 0);
+    y0 = MAX(y0, 0);
+    x1 = MIN(x1, maze_w);
+    y1 = MIN(y1, maze_h - 1);
+    if ((x0 > x1) || (y0 > y1))
+        return;
+    w0 = x0 >> 6;
+    w1 = x1 >> 6;
+    m0 = ~(uint64_t)0 << (x0 & 63);
+    m1 = ~(uint64_t)0 >> (63 - (x1 & 63));
+    for (y = y0; y <= y1; y++) {
+        uint64_t* row = dirty_cell + y * CELL_WORDS;
+
+        if (w0 == w1) {
+            row[w0] |= m0 & m1;
+            continue;
+        }
+        row[w0] |= m0;
+        for (w = w0 + 1; w < w1; w++)
+            row[w] = ~(uint64_t)0;
+        row[w1] |= m1;
+    }
+}
 
-        idx = ((y)) * ((maze_w + 1 + 7) >> 3) + ((x) >> 3);
-        dirty_cell[idx] =
-            (1U << ((x) & 7)) | (unsigned)(unsigned char)dirty_cell[idx];
+/**
+ * @brief Resolve the visual glyph of one cell of the current level
+ *
+ * Runs maze_visual() for the cell and then picks the tile it is drawn
+ * with: ':' and the ASCII wall letters become their CP437 forms, 'o'
+ * becomes a bullet when the tile set has no 'o', and glyphs missing
+ * from the tile set follow the fallback_cp437 chain.
+ *
+ * @param x Cell X coordinate (tile units)
+ * @param y Cell Y coordinate (tile units)
+ * @return maze_visual() in the low byte, the tile in the high byte
+ */
+static uint16_t resolve_glyph(int x, int y) {
+    int c, c_mapped;
+
+    c        = (int)maze_visual(maze_level, y, x);
+    c_mapped = c;
+    if (c_mapped == ':') {
+        c_mapped = ' ';
+    } else if (c_mapped == 'l') {
+        c_mapped = 179;
+    } else if (c_mapped == '~') {
+        c_mapped = 196;
+    } else if ((c_mapped == 'o') && (!tile_used[c_mapped])) {
+        c_mapped = 254;
+    }
+    while ((!tile_used[c_mapped]) &&
+           (((int)(unsigned)fallback_cp437[c_mapped]) != c) &&
+           (((int)(unsigned)fallback_cp437[c_mapped]) != c_mapped)) {
+        c_mapped = (int)(unsigned char)fallback_cp437[c_mapped];
+    }
+    return (uint16_t)((c_mapped << 8) | c);
+}
+
+/**
+ * @brief Bring the current level's visual glyph cache up to date
+ *
+ * Fills maze_glyph with resolve_glyph() for every cell so the renderer
+ * does one load per tile instead of a maze_visual() call per pixel.
+ * Does nothing while glyph_level says the cache still describes the
+ * current level. The glyphs only depend on blank_maze, which is fixed
+ * once paint_walls() has run, and on the cell itself, so writes to
+ * single cells refresh them through maze_glyph_cell(). Also notes the
+ * pellets in pellet_cell, which gamerender() redraws every frame.
+ *
+ * @see maze_glyph_cell, maze_visual
+ */
+void maze_glyphs(void) {
+    int i, j;
+
+    if (glyph_level == maze_level + 1)
+        return;
+    memset((void*)pellet_cell, 0, maze_h * CELL_WORDS * sizeof(*pellet_cell));
+    for (j = 0; j < maze_h; j++)
+        for (i = 0; i <= maze_w; i++) {
+            if (i < maze_w)
+                maze_glyph[j * (maze_w + 1) + i] = resolve_glyph(i, j);
+            if (ISPELLET((unsigned char)maze[(maze_level * maze_h + j) *
+                                                 (maze_w + 1) +
+                                             i]))
+                pellet_cell[j * CELL_WORDS + (i >> 6)] |= (uint64_t)1
+                                                          << (i & 63);
+        }
+    glyph_level = maze_level + 1;
+}
+
+/**
+ * @brief Refresh the cached visual glyph of a rewritten cell
+ *
+ * @param x Cell X coordinate (tile units)
+ * @param y Cell Y coordinate (tile units)
+ *
+ * @note No-op while the cache is stale; maze_glyphs() rebuilds it all
+ * @see maze_glyphs
+ */
+void maze_glyph_cell(int x, int y) {
+    if ((glyph_level == maze_level + 1) && (x >= 0) && (x < maze_w) &&
+        (y >= 0) && (y < maze_h)) {
+        maze_glyph[y * (maze_w + 1) + x] = resolve_glyph(x, y);
+        if (ISPELLET((unsigned char)
+                         maze[(maze_level * maze_h + y) * (maze_w + 1) + x]))
+            pellet_cell[y * CELL_WORDS + (x >> 6)] |= (uint64_t)1 << (x & 63);
     }
 }
 
@@ -67,6 +207,8 @@ void maze_erase(void) {
            (maze_w + 1) * maze_h);
     memset((void*)(maze_color + maze_level * maze_h * (maze_w + 1)), 0,
            (maze_w + 1) * maze_h);
+    route_level = 0;
+    glyph_level = 0;
     DIRTY_ALL();
 }
 
@@ -99,10 +241,18 @@ void maze_puts(int y, int x, int color, const char* s) {
     for (i = 0; 0 != (int)(unsigned char)(c = (unsigned)(unsigned char)(s)[i]);
          i++) {
         if (((x + i) >= 0) && ((x + i) < maze_w)) {
+            if ((CELL_CLASS((unsigned)(unsigned char)
+                                maze[(maze_level * maze_h + YWRAP(y)) *
+                                         (maze_w + 1) +
+                                     XWRAP(x + i)]) ^
+                 CELL_CLASS((unsigned)c)) &
+                (CELL_OPEN | CELL_DOOR | CELL_ZAP))
+                route_level = 0;
             maze[(maze_level * maze_h + YWRAP(y)) * (maze_w + 1) +
                  XWRAP(x + i)]       = c;
             maze_color[(maze_level * maze_h + YWRAP(y)) * (maze_w + 1) +
                        XWRAP(x + i)] = (char)(unsigned char)color;
+            maze_glyph_cell(XWRAP(x + i), YWRAP(y));
             mark_cell(XWRAP(x + i), YWRAP(y));
         }
     }
@@ -151,10 +301,18 @@ void maze_putsn_nonblank(int y, int x, int color, const char* s, int n) {
                                           (maze_w + 1) +
                                       XWRAP(x + i)];
             }
+            if ((CELL_CLASS((unsigned)(unsigned char)
+                                maze[(maze_level * maze_h + YWRAP(y)) *
+                                         (maze_w + 1) +
+                                     XWRAP(x + i)]) ^
+                 CELL_CLASS((unsigned)c)) &
+                (CELL_OPEN | CELL_DOOR | CELL_ZAP))
+                route_level = 0;
             maze[(maze_level * maze_h + YWRAP(y)) * (maze_w + 1) +
                  XWRAP(x + i)]       = c;
             maze_color[(maze_level * maze_h + YWRAP(y)) * (maze_w + 1) +
                        XWRAP(x + i)] = (char)(unsigned char)cc;
+            maze_glyph_cell(XWRAP(x + i), YWRAP(y));
             mark_cell(XWRAP(x + i), YWRAP(y));
         }
     }
@@ -171,826 +329,799 @@ void maze_putsn_nonblank(int y, int x, int color, const char* s, int n) {
  *
  * @note Marks rectangular region based on gfx_w/gfx_h and sgfx_w/sgfx_h
  * @note Called when sprite moves or changes
- * @see mark_cell, sprite_register_x, sprite_register_y
+ * @see mark_rect, sprite_register_x, sprite_register_y
  */
 void mark_sprite_register(int s) {
-    int _dirty_sprite_register_x, _dirty_sprite_register_y;
-
-    for (_dirty_sprite_register_y = 0;
-         _dirty_sprite_register_y < ((gfx_h > sgfx_h) ? gfx_h : sgfx_h);
-         _dirty_sprite_register_y++)
-        for (_dirty_sprite_register_x = 0;
-             _dirty_sprite_register_x < ((gfx_w > sgfx_w) ? gfx_w : sgfx_w);
-             _dirty_sprite_register_x++) {
-            mark_cell(XTILE(sprite_register_x[s] + _dirty_sprite_register_x -
-                            ((gfx_w > sgfx_w) ? gfx_w : sgfx_w) / 2),
-                      YTILE(sprite_register_y[s] + _dirty_sprite_register_y -
-                            ((gfx_h > sgfx_h) ? gfx_h : sgfx_h) / 2));
+    int w = MAX(gfx_w, sgfx_w);
+    int h = MAX(gfx_h, sgfx_h);
+    int x = sprite_register_x[s] - w / 2;
+    int y = sprite_register_y[s] - h / 2;
+
+    mark_rect(XTILE(x), YTILE(y), XTILE(x + w - 1), YTILE(y + h - 1));
+}
+
+/* scratch space for painting the walls of one level at a time */
+typedef struct {
+    uint16_t*      wall;    /* the level's slice of inside_wall */
+    unsigned char* ud;      /* udlr[] of each cell's maze_visual() */
+    int*           queued;  /* sweep a cell is queued for */
+    int*           heap;    /* cells left in this sweep, smallest first */
+    int            heap_n;
+    int*           next;    /* cells queued for the next sweep */
+    int            next_n;
+    int*           painted; /* cells made provisional by this paint */
+    int            painted_n;
+    int            sweep;
+    int            cur;     /* cell being looked at in this sweep */
+} wall_paint_t;
+
+static void paint_heap_push(wall_paint_t* p, int k) {
+    int i = p->heap_n++;
+
+    while (i && (p->heap[(i - 1) / 2] > k)) {
+        p->heap[i] = p->heap[(i - 1) / 2];
+        i          = (i - 1) / 2;
+    }
+    p->heap[i] = k;
+}
+
+static int paint_heap_pop(wall_paint_t* p) {
+    int top = p->heap[0];
+    int k   = p->heap[--p->heap_n];
+    int i   = 0;
+
+    for (;;) {
+        int c = 2 * i + 1;
+
+        if (c >= p->heap_n)
+            break;
+        if ((c + 1 < p->heap_n) && (p->heap[c + 1] < p->heap[c]))
+            c++;
+        if (p->heap[c] >= k)
+            break;
+        p->heap[i] = p->heap[c];
+        i          = c;
+    }
+    if (p->heap_n)
+        p->heap[i] = k;
+    return top;
+}
+
+/* queue cell k to be looked at again, later in this sweep if it is
+ * still ahead of the scan and in the next sweep otherwise */
+static void paint_queue(wall_paint_t* p, int k) {
+    if (k > p->cur) {
+        if (p->queued[k] != p->sweep) {
+            p->queued[k] = p->sweep;
+            paint_heap_push(p, k);
         }
+    } else if (p->queued[k] != p->sweep + 1) {
+        p->queued[k]         = p->sweep + 1;
+        p->next[p->next_n++] = k;
+    }
 }
-void paint_walls(int verbose) {
-    int    n;
-    double tdt, tdt2 = 0.0L;
-    int    tdt_used = 0;
-
-    memset((void*)inside_wall, '\0', sizeof(inside_wall));
-    tdt      = doubletime();
-    tdt_used = 0;
-    for (n = 0; n < maze_n; n++) {
-        int phase;
-
-        total_dots[n] = 0;
-        pellets[n]    = 0;
-        for (phase = 0; phase <= 4; phase++) {
-            int phase_done;
-
-            do {
-                int i;
-
-                phase_done = 1;
-                for (i = 0; i < maze_h; i++) {
-                    int j;
-
-                    if ((!nogame) && verbose) {
-                        tdt2 = doubletime();
-                        if ((tdt2 - tdt) >= 1.0) {
-                            tdt      = tdt2;
-                            tdt_used = 1;
-                            fprintf(stderr, "%3d%%\r",
-                                    (int)(((((float)n) * 5.0 + (float)phase) *
-                                               maze_h +
-                                           (float)i) *
-                                              100.0 /
-                                              (((float)maze_n) * 5.0 *
-                                               ((float)maze_h)) +
-                                          0.5));
-                            fflush(stderr);
-                        }
-                    }
-                    for (j = 0; j <= maze_w; j++) {
-                        long c;
-
-                        c = maze_visual(n, i, j);
-                        switch (phase) {
-                        case 0:
-                            if (ISPELLET(c) || ISDOT(c)) {
-                                total_dots[n]++;
-                                if (ISPELLET(c)) {
-                                    pellets[n]++;
-                                }
-                            }
-                            if (ISNONINVERTABLE(c)) {
-                                inside_wall[(n * maze_h + i) * (maze_w + 1) +
-                                            j] =
-                                    ((unsigned)inside_wall[(n * maze_h + i) *
-                                                               (maze_w + 1) +
-                                                           j]) |
-                                    INSIDE_WALL_NON_INVERTABLE;
-                            }
-                            break;
-                        case 1:
-                            if ((!(((unsigned)inside_wall
-                                        [(n * maze_h + i) * (maze_w + 1) + j]) &
-                                   INSIDE_WALL_NON_INVERTABLE)) &&
-                                (!((unsigned)udlr[c])) &&
-                                ((((unsigned)
-                                       inside_wall[(n * maze_h + YWRAP(i - 1)) *
-                                                       (maze_w + 1) +
-                                                   j]) &
-                                  INSIDE_WALL_NON_INVERTABLE) ||
-                                 (((unsigned)
-                                       inside_wall[(n * maze_h + YWRAP(i + 1)) *
-                                                       (maze_w + 1) +
-                                                   j]) &
-                                  INSIDE_WALL_NON_INVERTABLE) ||
-                                 (((unsigned)inside_wall[(n * maze_h + i) *
-                                                             (maze_w + 1) +
-                                                         XWRAP2(j - 1)]) &
-                                  INSIDE_WALL_NON_INVERTABLE) ||
-                                 (((unsigned)inside_wall[(n * maze_h + i) *
-                                                             (maze_w + 1) +
-                                                         XWRAP2(j + 1)]) &
-                                  INSIDE_WALL_NON_INVERTABLE))) {
-                                inside_wall[(n * maze_h + i) * (maze_w + 1) +
-                                            j] =
-                                    ((unsigned)inside_wall[(n * maze_h + i) *
-                                                               (maze_w + 1) +
-                                                           j]) |
-                                    INSIDE_WALL_NON_INVERTABLE;
-                                phase_done = 0;
-                            }
-                            break;
-                        case 2:
-                        case 3:
-                            if ((!(((unsigned)inside_wall
-                                        [(n * maze_h + i) * (maze_w + 1) + j]) &
-                                   (INSIDE_WALL_NON_INVERTABLE |
-                                    INSIDE_WALL_PROVISIONAL | INSIDE_WALL_YES |
-                                    INSIDE_WALL_NO |
-                                    ((phase == 2) ? INSIDE_WALL_PHASE2
-                                                  : INSIDE_WALL_PHASE3)))) &&
-                                ((phase == 3) ||
-                                 ((((((unsigned)inside_wall[(n * maze_h +
-                                                             YWRAP(i - 1)) *
-                                                                (maze_w + 1) +
-                                                            j]) &
-                                     INSIDE_WALL_NON_INVERTABLE) ^
-                                    (((unsigned)inside_wall[(n * maze_h +
-                                                             YWRAP(i + 1)) *
-                                                                (maze_w + 1) +
-                                                            j]) &
-                                     INSIDE_WALL_NON_INVERTABLE)) &&
-                                   ((((unsigned)udlr[c]) & 0x05) == 0x05)) ||
-                                  (((((unsigned)inside_wall[(n * maze_h + i) *
-                                                                (maze_w + 1) +
-                                                            XWRAP2(j - 1)]) &
-                                     INSIDE_WALL_NON_INVERTABLE) ^
-                                    (((unsigned)inside_wall[(n * maze_h + i) *
-                                                                (maze_w + 1) +
-                                                            XWRAP2(j + 1)]) &
-                                     INSIDE_WALL_NON_INVERTABLE)) &&
-                                   ((((unsigned)udlr[c]) & 0x50) == 0x50))))) {
-                                int painting_done;
-
-                                inside_wall[(n * maze_h + i) * (maze_w + 1) +
-                                            j] =
-                                    ((unsigned)inside_wall[(n * maze_h + i) *
-                                                               (maze_w + 1) +
-                                                           j]) |
-                                    INSIDE_WALL_PROVISIONAL;
-                                if ((((unsigned)inside_wall[(n * maze_h +
-                                                             YWRAP(i - 1)) *
-                                                                (maze_w + 1) +
-                                                            j]) &
-                                     INSIDE_WALL_NON_INVERTABLE) &&
-                                    ((((unsigned)udlr[c]) & 0x05) == 0x05)) {
-                                    inside_wall[(n * maze_h + i) *
-                                                    (maze_w + 1) +
-                                                j] =
-                                        ((unsigned)
-                                             inside_wall[(n * maze_h + i) *
-                                                             (maze_w + 1) +
-                                                         j]) |
-                                        INSIDE_WALL_NO;
-                                    if (!(((unsigned)
-                                               inside_wall[(n * maze_h +
-                                                            YWRAP(i + 1)) *
-                                                               (maze_w + 1) +
-                                                           j]) &
-                                          (INSIDE_WALL_NON_INVERTABLE |
-                                           INSIDE_WALL_PROVISIONAL |
-                                           INSIDE_WALL_YES | INSIDE_WALL_NO))) {
-                                        inside_wall[(n * maze_h +
-                                                     YWRAP(i + 1)) *
-                                                        (maze_w + 1) +
-                                                    j] =
-                                            ((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i + 1)) *
-                                                                 (maze_w + 1) +
-                                                             j]) |
-                                            (INSIDE_WALL_YES |
-                                             INSIDE_WALL_PROVISIONAL);
-                                    }
-                                } else if ((((unsigned)
-                                                 inside_wall[(n * maze_h + i) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j - 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) &&
-                                           ((((unsigned)udlr[c]) & 0x50) ==
-                                            0x50)) {
-                                    inside_wall[(n * maze_h + i) *
-                                                    (maze_w + 1) +
-                                                j] =
-                                        ((unsigned)
-                                             inside_wall[(n * maze_h + i) *
-                                                             (maze_w + 1) +
-                                                         j]) |
-                                        INSIDE_WALL_NO;
-                                    if (!(((unsigned)
-                                               inside_wall[(n * maze_h + i) *
-                                                               (maze_w + 1) +
-                                                           XWRAP2(j + 1)]) &
-                                          (INSIDE_WALL_NON_INVERTABLE |
-                                           INSIDE_WALL_PROVISIONAL |
-                                           INSIDE_WALL_YES | INSIDE_WALL_NO))) {
-                                        inside_wall[(n * maze_h + i) *
-                                                        (maze_w + 1) +
-                                                    XWRAP2(j + 1)] =
-                                            ((unsigned)
-                                                 inside_wall[(n * maze_h + i) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j + 1)]) |
-                                            (INSIDE_WALL_YES |
-                                             INSIDE_WALL_PROVISIONAL);
-                                    }
-                                } else {
-                                    inside_wall[(n * maze_h + i) *
-                                                    (maze_w + 1) +
-                                                j] =
-                                        ((unsigned)
-                                             inside_wall[(n * maze_h + i) *
-                                                             (maze_w + 1) +
-                                                         j]) |
-                                        INSIDE_WALL_YES;
-                                }
-                                do {
-                                    int i2, j2;
-                                    int undo = 0;
-
-                                    painting_done = 1;
-                                    for (i2 = 0; i2 < maze_h; i2++)
-                                        for (j2 = 0; j2 <= maze_w; j2++) {
-                                            long c2;
-
-                                            c2 = maze_visual(n, i2, j2);
-                                            if (!undo) {
-                                                if (((!(((unsigned)udlr[c2]) &
-                                                        0x04)) &&
-                                                     (((unsigned)inside_wall
-                                                           [(n * maze_h +
-                                                             YWRAP(i2 + 1)) *
-                                                                (maze_w + 1) +
-                                                            j2]) &
-                                                      INSIDE_WALL_YES)) ||
-                                                    ((!(((unsigned)udlr[c2]) &
-                                                        0x40)) &&
-                                                     (((unsigned)inside_wall
-                                                           [(n * maze_h + i2) *
-                                                                (maze_w + 1) +
-                                                            XWRAP2(j2 + 1)]) &
-                                                      INSIDE_WALL_YES))) {
-                                                    if (((unsigned)inside_wall
-                                                             [(n * maze_h +
-                                                               i2) *
-                                                                  (maze_w + 1) +
-                                                              j2]) &
-                                                        (INSIDE_WALL_NON_INVERTABLE |
-                                                         INSIDE_WALL_NO)) {
-                                                        undo          = 1;
-                                                        i2            = 0;
-                                                        j2            = 0;
-                                                        painting_done = 1;
-                                                    } else {
-                                                        if (!(((unsigned)inside_wall
-                                                                   [(n * maze_h +
-                                                                     i2) *
-                                                                        (maze_w +
-                                                                         1) +
-                                                                    j2]) &
-                                                              INSIDE_WALL_YES)) {
-                                                            inside_wall[(n * maze_h +
-                                                                         i2) *
-                                                                            (maze_w +
-                                                                             1) +
-                                                                        j2] =
-                                                                ((unsigned)inside_wall
-                                                                     [(n * maze_h +
-                                                                       i2) *
-                                                                          (maze_w +
-                                                                           1) +
-                                                                      j2]) |
-                                                                INSIDE_WALL_PROVISIONAL |
-                                                                INSIDE_WALL_YES;
-                                                            painting_done = 0;
-                                                        }
-                                                    }
-                                                } else if (
-                                                    ((((unsigned)udlr[c2]) &
-                                                      0x04) &&
-                                                     ((((unsigned)inside_wall
-                                                            [(n * maze_h +
-                                                              YWRAP(i2 + 1)) *
-                                                                 (maze_w + 1) +
-                                                             j2]) &
-                                                       (INSIDE_WALL_PROVISIONAL |
-                                                        INSIDE_WALL_YES)) ==
-                                                      ((INSIDE_WALL_PROVISIONAL |
-                                                        INSIDE_WALL_YES) ^
-                                                       (((unsigned)inside_wall
-                                                             [(n * maze_h +
-                                                               i2) *
-                                                                  (maze_w + 1) +
-                                                              j2]) &
-                                                        INSIDE_WALL_PROVISIONAL)))) ||
-                                                    ((((unsigned)udlr[c2]) &
-                                                      0x40) &&
-                                                     ((((unsigned)inside_wall
-                                                            [(n * maze_h + i2) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j2 + 1)]) &
-                                                       (INSIDE_WALL_PROVISIONAL |
-                                                        INSIDE_WALL_YES)) ==
-                                                      ((INSIDE_WALL_PROVISIONAL |
-                                                        INSIDE_WALL_YES) ^
-                                                       (((unsigned)inside_wall
-                                                             [(n * maze_h +
-                                                               i2) *
-                                                                  (maze_w + 1) +
-                                                              j2]) &
-                                                        INSIDE_WALL_PROVISIONAL))))) {
-                                                    if ((((unsigned)inside_wall
-                                                              [(n * maze_h +
-                                                                i2) *
-                                                                   (maze_w +
-                                                                    1) +
-                                                               j2]) &
-                                                         INSIDE_WALL_YES) ==
-                                                        INSIDE_WALL_YES) {
-                                                        undo          = 1;
-                                                        i2            = 0;
-                                                        j2            = 0;
-                                                        painting_done = 1;
-                                                    }
-                                                }
-                                            }
-                                            if (!undo) {
-                                                if ((((unsigned)inside_wall
-                                                          [(n * maze_h + i2) *
-                                                               (maze_w + 1) +
-                                                           j2]) &
-                                                     INSIDE_WALL_YES) &&
-                                                    (!(((unsigned)udlr[c2]) &
-                                                       0x04))) {
-                                                    if (((unsigned)inside_wall
-                                                             [(n * maze_h +
-                                                               YWRAP(i2 + 1)) *
-                                                                  (maze_w + 1) +
-                                                              j2]) &
-                                                        (INSIDE_WALL_NON_INVERTABLE |
-                                                         INSIDE_WALL_NO)) {
-                                                        undo          = 1;
-                                                        i2            = 0;
-                                                        j2            = 0;
-                                                        painting_done = 1;
-                                                    } else {
-                                                        if (!(((unsigned)inside_wall
-                                                                   [(n * maze_h +
-                                                                     YWRAP(i2 +
-                                                                           1)) *
-                                                                        (maze_w +
-                                                                         1) +
-                                                                    j2]) &
-                                                              INSIDE_WALL_YES)) {
-                                                            inside_wall[(n * maze_h +
-                                                                         YWRAP(
-                                                                             i2 +
-                                                                             1)) *
-                                                                            (maze_w +
-                                                                             1) +
-                                                                        j2] =
-                                                                ((unsigned)inside_wall
-                                                                     [(n * maze_h +
-                                                                       YWRAP(
-                                                                           i2 +
-                                                                           1)) *
-                                                                          (maze_w +
-                                                                           1) +
-                                                                      j2]) |
-                                                                INSIDE_WALL_PROVISIONAL |
-                                                                INSIDE_WALL_YES;
-                                                            painting_done = 0;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            if (!undo) {
-                                                if ((((unsigned)inside_wall
-                                                          [(n * maze_h + i2) *
-                                                               (maze_w + 1) +
-                                                           j2]) &
-                                                     INSIDE_WALL_YES) &&
-                                                    (!(((unsigned)udlr[c2]) &
-                                                       0x40))) {
-                                                    if (((unsigned)inside_wall
-                                                             [(n * maze_h +
-                                                               i2) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j2 + 1)]) &
-                                                        (INSIDE_WALL_NON_INVERTABLE |
-                                                         INSIDE_WALL_NO)) {
-                                                        undo          = 1;
-                                                        i2            = 0;
-                                                        j2            = 0;
-                                                        painting_done = 1;
-                                                    } else {
-                                                        if (!(((unsigned)inside_wall
-                                                                   [(n * maze_h +
-                                                                     i2) *
-                                                                        (maze_w +
-                                                                         1) +
-                                                                    XWRAP2(
-                                                                        j2 +
-                                                                        1)]) &
-                                                              INSIDE_WALL_YES)) {
-                                                            inside_wall[(n * maze_h +
-                                                                         i2) *
-                                                                            (maze_w +
-                                                                             1) +
-                                                                        XWRAP2(
-                                                                            j2 +
-                                                                            1)] =
-                                                                ((unsigned)inside_wall
-                                                                     [(n * maze_h +
-                                                                       i2) *
-                                                                          (maze_w +
-                                                                           1) +
-                                                                      XWRAP2(
-                                                                          j2 +
-                                                                          1)]) |
-                                                                INSIDE_WALL_PROVISIONAL |
-                                                                INSIDE_WALL_YES;
-                                                            painting_done = 0;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            if (undo) {
-                                                if (((unsigned)inside_wall
-                                                         [(n * maze_h + i2) *
-                                                              (maze_w + 1) +
-                                                          j2]) &
-                                                    INSIDE_WALL_PROVISIONAL) {
-                                                    inside_wall[(n * maze_h +
-                                                                 i2) *
-                                                                    (maze_w +
-                                                                     1) +
-                                                                j2] =
-                                                        ((unsigned)inside_wall
-                                                             [(n * maze_h +
-                                                               i2) *
-                                                                  (maze_w + 1) +
-                                                              j2]) &
-                                                        ~(INSIDE_WALL_PROVISIONAL |
-                                                          INSIDE_WALL_YES |
-                                                          INSIDE_WALL_NO);
-                                                }
-                                            }
-                                        }
-                                } while (!painting_done);
-                                {
-                                    int i2, j2;
-
-                                    for (i2 = 0; i2 < maze_h; i2++)
-                                        for (j2 = 0; j2 <= maze_w; j2++) {
-                                            if (((unsigned)inside_wall
-                                                     [(n * maze_h + i2) *
-                                                          (maze_w + 1) +
-                                                      j2]) &
-                                                INSIDE_WALL_PROVISIONAL) {
-                                                inside_wall[(n * maze_h + i2) *
-                                                                (maze_w + 1) +
-                                                            j2] =
-                                                    ((unsigned)inside_wall
-                                                         [(n * maze_h + i2) *
-                                                              (maze_w + 1) +
-                                                          j2]) &
-                                                    ~INSIDE_WALL_PROVISIONAL;
-                                            }
-                                        }
-                                }
-                                phase_done = 0;
-                                inside_wall[(n * maze_h + i) * (maze_w + 1) +
-                                            j] =
-                                    ((unsigned)inside_wall[(n * maze_h + i) *
-                                                               (maze_w + 1) +
-                                                           j]) |
-                                    ((phase == 2) ? INSIDE_WALL_PHASE2
-                                                  : INSIDE_WALL_PHASE3);
-                            }
-                            break;
-                        case 4:
-                            if (!(((unsigned)inside_wall
-                                       [(n * maze_h + i) * (maze_w + 1) + j]) &
-                                  INSIDE_WALL_NON_INVERTABLE)) {
-                                int ul, ll, ur, lr;
-
-                                ul =
-                                    !!(((unsigned)inside_wall[(n * maze_h + i) *
-                                                                  (maze_w + 1) +
-                                                              j]) &
-                                       INSIDE_WALL_YES);
-                                ll =
-                                    !!(((unsigned)inside_wall[(n * maze_h +
-                                                               YWRAP(i + 1)) *
-                                                                  (maze_w + 1) +
-                                                              j]) &
-                                       INSIDE_WALL_YES);
-                                ur =
-                                    !!(((unsigned)inside_wall[(n * maze_h + i) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j + 1)]) &
-                                       INSIDE_WALL_YES);
-                                lr =
-                                    !!(((unsigned)inside_wall[(n * maze_h +
-                                                               YWRAP(i + 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j + 1)]) &
-                                       INSIDE_WALL_YES);
-                                if ((ul + ll + ur + lr) == 0) {
-                                    if ((((unsigned)udlr[c]) & 0x05) == 0x05) {
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i - 1)) *
-                                                                 (maze_w + 1) +
-                                                             j]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ll = 1;
-                                            lr = 1;
-                                        }
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i + 1)) *
-                                                                 (maze_w + 1) +
-                                                             j]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ul = 1;
-                                            ur = 1;
-                                        }
-                                    }
-                                    if ((((unsigned)udlr[c]) & 0x50) == 0x50) {
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h + i) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j + 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ul = 1;
-                                            ll = 1;
-                                        }
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h + i) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j - 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ur = 1;
-                                            lr = 1;
-                                        }
-                                    }
-                                    if ((((unsigned)udlr[c]) & 0x55) == 0x44) {
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i - 1)) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j - 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ur = 1;
-                                            ll = 1;
-                                            lr = 1;
-                                        }
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i + 1)) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j + 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ul = 1;
-                                        }
-                                    }
-                                    if ((((unsigned)udlr[c]) & 0x55) == 0x41) {
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i - 1)) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j + 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ul = 1;
-                                            ll = 1;
-                                            lr = 1;
-                                        }
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i + 1)) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j - 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ur = 1;
-                                        }
-                                    }
-                                    if ((((unsigned)udlr[c]) & 0x55) == 0x14) {
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i + 1)) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j - 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ul = 1;
-                                            ur = 1;
-                                            lr = 1;
-                                        }
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i - 1)) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j + 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ll = 1;
-                                        }
-                                    }
-                                    if ((((unsigned)udlr[c]) & 0x55) == 0x11) {
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i + 1)) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j + 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ul = 1;
-                                            ur = 1;
-                                            ll = 1;
-                                        }
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i - 1)) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j - 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            lr = 1;
-                                        }
-                                    }
-                                    if ((((unsigned)udlr[c]) & 0x55) == 0x15) {
-                                        if ((((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i + 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j - 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE) ||
-                                            (((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i + 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j + 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE)) {
-                                            ul = 1;
-                                            ur = 1;
-                                        }
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i - 1)) *
-                                                                 (maze_w + 1) +
-                                                             j]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ll = 1;
-                                            lr = 1;
-                                        }
-                                    }
-                                    if ((((unsigned)udlr[c]) & 0x55) == 0x45) {
-                                        if ((((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i - 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j - 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE) ||
-                                            (((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i - 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j + 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE)) {
-                                            ll = 1;
-                                            lr = 1;
-                                        }
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h +
-                                                              YWRAP(i + 1)) *
-                                                                 (maze_w + 1) +
-                                                             j]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ul = 1;
-                                            ur = 1;
-                                        }
-                                    }
-                                    if ((((unsigned)udlr[c]) & 0x55) == 0x51) {
-                                        if ((((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i - 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j + 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE) ||
-                                            (((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i + 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j + 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE)) {
-                                            ul = 1;
-                                            ll = 1;
-                                        }
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h + i) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j - 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ur = 1;
-                                            lr = 1;
-                                        }
-                                    }
-                                    if ((((unsigned)udlr[c]) & 0x55) == 0x54) {
-                                        if ((((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i - 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j - 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE) ||
-                                            (((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i + 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j - 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE)) {
-                                            ur = 1;
-                                            lr = 1;
-                                        }
-                                        if (((unsigned)
-                                                 inside_wall[(n * maze_h + i) *
-                                                                 (maze_w + 1) +
-                                                             XWRAP2(j + 1)]) &
-                                            INSIDE_WALL_NON_INVERTABLE) {
-                                            ul = 1;
-                                            ll = 1;
-                                        }
-                                    }
-                                    if ((((unsigned)udlr[c]) & 0x55) == 0x55) {
-                                        if ((((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i - 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j - 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE) ||
-                                            (((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i + 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j + 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE)) {
-                                            ur = 1;
-                                            ll = 1;
-                                        }
-                                        if ((((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i - 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j + 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE) ||
-                                            (((unsigned)
-                                                  inside_wall[(n * maze_h +
-                                                               YWRAP(i + 1)) *
-                                                                  (maze_w + 1) +
-                                                              XWRAP2(j - 1)]) &
-                                             INSIDE_WALL_NON_INVERTABLE)) {
-                                            ul = 1;
-                                            lr = 1;
-                                        }
-                                    }
-                                    if ((ul + ur + ll + lr) == 4) {
-                                        ul = 0;
-                                        ur = 0;
-                                        ll = 0;
-                                        lr = 0;
-                                        inside_wall[(n * maze_h + i) *
-                                                        (maze_w + 1) +
-                                                    j] =
-                                            ((unsigned)
-                                                 inside_wall[(n * maze_h + i) *
-                                                                 (maze_w + 1) +
-                                                             j]) |
-                                            INSIDE_WALL_FULLY_NON_INVERTED;
-                                    }
-                                }
-                                if (((ul + ll + ur + lr) > 2) ||
-                                    (((ul + ll + ur + lr) == 2) && ul)) {
-                                    inside_wall[(n * maze_h + i) *
-                                                    (maze_w + 1) +
-                                                j] =
-                                        ((unsigned)
-                                             inside_wall[(n * maze_h + i) *
-                                                             (maze_w + 1) +
-                                                         j]) |
-                                        INSIDE_WALL_INVERTED;
-                                }
-                                if (((ul + ll + ur + lr) == 4) &&
-                                    (((!!(((unsigned)udlr[c]) & 0x40)) +
-                                      (!!(((unsigned)udlr[c]) & 0x10)) +
-                                      (!!(((unsigned)udlr[c]) & 0x04)) +
-                                      (!!(((unsigned)udlr[c]) & 0x01))) > 1)) {
-                                    inside_wall[(n * maze_h + i) *
-                                                    (maze_w + 1) +
-                                                j] =
-                                        ((unsigned)
-                                             inside_wall[(n * maze_h + i) *
-                                                             (maze_w + 1) +
-                                                         j]) |
-                                        INSIDE_WALL_FULLY_INVERTED;
-                                }
-                            }
-                            break;
-                        }
-                    }
+
+/* set flags on cell k and queue the cells whose look at their own,
+ * lower and right-hand cells can change because of it */
+static void paint_set(wall_paint_t* p, int k, unsigned flags) {
+    int i = k / (maze_w + 1);
+    int j = k % (maze_w + 1);
+
+    if (!(p->wall[k] & INSIDE_WALL_PROVISIONAL))
+        p->painted[p->painted_n++] = k;
+    p->wall[k] |= flags;
+    paint_queue(p, k);
+    paint_queue(p, YWRAP(i - 1) * (maze_w + 1) + j);
+    if (j) {
+        paint_queue(p, k - 1);
+    } else {
+        paint_queue(p, i * (maze_w + 1) + maze_w - 1);
+        paint_queue(p, i * (maze_w + 1) + maze_w);
+    }
+}
+
+/**
+ * @brief Look at one cell of a provisional painting
+ *
+ * Pulls INSIDE_WALL_YES into cell @p k from its lower and right-hand
+ * neighbours and pushes it back out across open sides, exactly as one
+ * step of a scan over the whole level would.
+ *
+ * @return nonzero if the painting runs into a non-invertable cell, a
+ * cell painted INSIDE_WALL_NO or the other side of a wall and has to be
+ * undone
+ */
+static int paint_step(wall_paint_t* p, int k) {
+    uint16_t* wall = p->wall;
+    unsigned  u    = p->ud[k];
+    int       i    = k / (maze_w + 1);
+    int       j    = k % (maze_w + 1);
+    int       b    = YWRAP(i + 1) * (maze_w + 1) + j;
+    int       r    = i * (maze_w + 1) + XWRAP2(j + 1);
+    unsigned  mine;
+
+    if (((!(u & 0x04)) && (wall[b] & INSIDE_WALL_YES)) ||
+        ((!(u & 0x40)) && (wall[r] & INSIDE_WALL_YES))) {
+        if (wall[k] & (INSIDE_WALL_NON_INVERTABLE | INSIDE_WALL_NO))
+            return 1;
+        if (!(wall[k] & INSIDE_WALL_YES))
+            paint_set(p, k, INSIDE_WALL_PROVISIONAL | INSIDE_WALL_YES);
+    } else {
+        /* a wall with paint on both sides, only one of them new */
+        mine = (INSIDE_WALL_PROVISIONAL | INSIDE_WALL_YES) ^
+               (wall[k] & INSIDE_WALL_PROVISIONAL);
+        if ((((u & 0x04) && ((wall[b] & (INSIDE_WALL_PROVISIONAL |
+                                          INSIDE_WALL_YES)) == mine)) ||
+             ((u & 0x40) && ((wall[r] & (INSIDE_WALL_PROVISIONAL |
+                                          INSIDE_WALL_YES)) == mine))) &&
+            (wall[k] & INSIDE_WALL_YES))
+            return 1;
+    }
+    if ((wall[k] & INSIDE_WALL_YES) && (!(u & 0x04))) {
+        if (wall[b] & (INSIDE_WALL_NON_INVERTABLE | INSIDE_WALL_NO))
+            return 1;
+        if (!(wall[b] & INSIDE_WALL_YES))
+            paint_set(p, b, INSIDE_WALL_PROVISIONAL | INSIDE_WALL_YES);
+    }
+    if ((wall[k] & INSIDE_WALL_YES) && (!(u & 0x40))) {
+        if (wall[r] & (INSIDE_WALL_NON_INVERTABLE | INSIDE_WALL_NO))
+            return 1;
+        if (!(wall[r] & INSIDE_WALL_YES))
+            paint_set(p, r, INSIDE_WALL_PROVISIONAL | INSIDE_WALL_YES);
+    }
+    return 0;
+}
+
+/**
+ * @brief Try painting the inside of a wall starting at cell (i, j)
+ *
+ * Marks the cell provisional, flood-fills INSIDE_WALL_YES from it, and
+ * then either keeps the painting or, if paint_step() ran into a
+ * conflict, takes all of it back. Afterwards the cell is marked @p done
+ * so it is never used to start a painting again.
+ *
+ * The fill visits the cells in the same order as repeated scans over
+ * the whole level, which decides whether it ends in a conflict, but
+ * only looks again at cells next to paint that changed since.
+ */
+static void paint_wall(wall_paint_t* p, int i, int j, unsigned done) {
+    uint16_t* wall = p->wall;
+    int       k    = i * (maze_w + 1) + j;
+    unsigned  u    = p->ud[k];
+    int       undo = 0;
+
+    p->sweep += 2;
+    p->cur       = -1;
+    p->heap_n    = 0;
+    p->next_n    = 0;
+    p->painted_n = 0;
+    paint_set(p, k, INSIDE_WALL_PROVISIONAL);
+    if ((wall[YWRAP(i - 1) * (maze_w + 1) + j] &
+         INSIDE_WALL_NON_INVERTABLE) &&
+        ((u & 0x05) == 0x05)) {
+        int b = YWRAP(i + 1) * (maze_w + 1) + j;
+
+        paint_set(p, k, INSIDE_WALL_NO);
+        if (!(wall[b] & (INSIDE_WALL_NON_INVERTABLE | INSIDE_WALL_PROVISIONAL |
+                         INSIDE_WALL_YES | INSIDE_WALL_NO)))
+            paint_set(p, b, INSIDE_WALL_YES | INSIDE_WALL_PROVISIONAL);
+    } else if ((wall[i * (maze_w + 1) + XWRAP2(j - 1)] &
+                INSIDE_WALL_NON_INVERTABLE) &&
+               ((u & 0x50) == 0x50)) {
+        int r = i * (maze_w + 1) + XWRAP2(j + 1);
+
+        paint_set(p, k, INSIDE_WALL_NO);
+        if (!(wall[r] & (INSIDE_WALL_NON_INVERTABLE | INSIDE_WALL_PROVISIONAL |
+                         INSIDE_WALL_YES | INSIDE_WALL_NO)))
+            paint_set(p, r, INSIDE_WALL_YES | INSIDE_WALL_PROVISIONAL);
+    } else {
+        paint_set(p, k, INSIDE_WALL_YES);
+    }
+    while (p->heap_n || p->next_n) {
+        if (!p->heap_n) {
+            int n;
+
+            p->sweep++;
+            p->cur = -1;
+            for (n = 0; n < p->next_n; n++)
+                paint_heap_push(p, p->next[n]);
+            p->next_n = 0;
+        }
+        p->cur = paint_heap_pop(p);
+        if (paint_step(p, p->cur)) {
+            undo = 1;
+            break;
+        }
+    }
+    for (k = 0; k < p->painted_n; k++)
+        wall[p->painted[k]] &=
+            ~(undo ? (INSIDE_WALL_PROVISIONAL | INSIDE_WALL_YES |
+                      INSIDE_WALL_NO)
+                   : INSIDE_WALL_PROVISIONAL);
+    wall[i * (maze_w + 1) + j] |= done;
+}
+
+/* does any of the cells around (i, j) have INSIDE_WALL_NON_INVERTABLE? */
+static int next_to_non_invertable(const uint16_t* wall, int i, int j) {
+    return (wall[YWRAP(i - 1) * (maze_w + 1) + j] |
+            wall[YWRAP(i + 1) * (maze_w + 1) + j] |
+            wall[i * (maze_w + 1) + XWRAP2(j - 1)] |
+            wall[i * (maze_w + 1) + XWRAP2(j + 1)]) &
+           INSIDE_WALL_NON_INVERTABLE;
+}
+
+/**
+ * @brief Work out which corners of cell (i, j) are inside a wall
+ *
+ * Sets INSIDE_WALL_INVERTED, INSIDE_WALL_FULLY_INVERTED and
+ * INSIDE_WALL_FULLY_NON_INVERTED from the painting of the cell and its
+ * neighbours, guessing from the non-invertable cells around wall pieces
+ * no painting reached.
+ */
+static void paint_corners(uint16_t* wall, int i, int j, unsigned u) {
+    int up  = YWRAP(i - 1) * (maze_w + 1);
+    int mid = i * (maze_w + 1);
+    int dn  = YWRAP(i + 1) * (maze_w + 1);
+    int lf  = XWRAP2(j - 1);
+    int rt  = XWRAP2(j + 1);
+    int ul, ll, ur, lr;
+
+#define PAINT_NI(k) (wall[k] & INSIDE_WALL_NON_INVERTABLE)
+    if (PAINT_NI(mid + j))
+        return;
+    ul = !!(wall[mid + j] & INSIDE_WALL_YES);
+    ll = !!(wall[dn + j] & INSIDE_WALL_YES);
+    ur = !!(wall[mid + rt] & INSIDE_WALL_YES);
+    lr = !!(wall[dn + rt] & INSIDE_WALL_YES);
+    if ((ul + ll + ur + lr) == 0) {
+        if ((u & 0x05) == 0x05) {
+            if (PAINT_NI(up + j)) {
+                ll = 1;
+                lr = 1;
+            }
+            if (PAINT_NI(dn + j)) {
+                ul = 1;
+                ur = 1;
+            }
+        }
+        if ((u & 0x50) == 0x50) {
+            if (PAINT_NI(mid + rt)) {
+                ul = 1;
+                ll = 1;
+            }
+            if (PAINT_NI(mid + lf)) {
+                ur = 1;
+                lr = 1;
+            }
+        }
+        if ((u & 0x55) == 0x44) {
+            if (PAINT_NI(up + lf)) {
+                ur = 1;
+                ll = 1;
+                lr = 1;
+            }
+            if (PAINT_NI(dn + rt)) {
+                ul = 1;
+            }
+        }
+        if ((u & 0x55) == 0x41) {
+            if (PAINT_NI(up + rt)) {
+                ul = 1;
+                ll = 1;
+                lr = 1;
+            }
+            if (PAINT_NI(dn + lf)) {
+                ur = 1;
+            }
+        }
+        if ((u & 0x55) == 0x14) {
+            if (PAINT_NI(dn + lf)) {
+                ul = 1;
+                ur = 1;
+                lr = 1;
+            }
+            if (PAINT_NI(up + rt)) {
+                ll = 1;
+            }
+        }
+        if ((u & 0x55) == 0x11) {
+            if (PAINT_NI(dn + rt)) {
+                ul = 1;
+                ur = 1;
+                ll = 1;
+            }
+            if (PAINT_NI(up + lf)) {
+                lr = 1;
+            }
+        }
+        if ((u & 0x55) == 0x15) {
+            if (PAINT_NI(dn + lf) || PAINT_NI(dn + rt)) {
+                ul = 1;
+                ur = 1;
+            }
+            if (PAINT_NI(up + j)) {
+                ll = 1;
+                lr = 1;
+            }
+        }
+        if ((u & 0x55) == 0x45) {
+            if (PAINT_NI(up + lf) || PAINT_NI(up + rt)) {
+                ll = 1;
+                lr = 1;
+            }
+            if (PAINT_NI(dn + j)) {
+                ul = 1;
+                ur = 1;
+            }
+        }
+        if ((u & 0x55) == 0x51) {
+            if (PAINT_NI(up + rt) || PAINT_NI(dn + rt)) {
+                ul = 1;
+                ll = 1;
+            }
+            if (PAINT_NI(mid + lf)) {
+                ur = 1;
+                lr = 1;
+            }
+        }
+        if ((u & 0x55) == 0x54) {
+            if (PAINT_NI(up + lf) || PAINT_NI(dn + lf)) {
+                ur = 1;
+                lr = 1;
+            }
+            if (PAINT_NI(mid + rt)) {
+                ul = 1;
+                ll = 1;
+            }
+        }
+        if ((u & 0x55) == 0x55) {
+            if (PAINT_NI(up + lf) || PAINT_NI(dn + rt)) {
+                ur = 1;
+                ll = 1;
+            }
+            if (PAINT_NI(up + rt) || PAINT_NI(dn + lf)) {
+                ul = 1;
+                lr = 1;
+            }
+        }
+        if ((ul + ur + ll + lr) == 4) {
+            ul = 0;
+            ur = 0;
+            ll = 0;
+            lr = 0;
+            wall[mid + j] |= INSIDE_WALL_FULLY_NON_INVERTED;
+        }
+    }
+#undef PAINT_NI
+    if (((ul + ll + ur + lr) > 2) || (((ul + ll + ur + lr) == 2) && ul))
+        wall[mid + j] |= INSIDE_WALL_INVERTED;
+    if (((ul + ll + ur + lr) == 4) &&
+        (((!!(u & 0x40)) + (!!(u & 0x10)) + (!!(u & 0x04)) + (!!(u & 0x01))) >
+         1))
+        wall[mid + j] |= INSIDE_WALL_FULLY_INVERTED;
+}
+
+/**
+ * @brief Count the dots of level @p n and work out its wall insides
+ *
+ * Phase 0 counts dots and pellets and marks the non-invertable cells.
+ * Phase 1 grows the non-invertable area into the open cells next to it
+ * with a worklist. Phases 2 and 3 paint the inside of the walls from
+ * the cells next to a non-invertable side, then from every cell left
+ * over. Phase 4 turns the painting into the INSIDE_WALL_* corner flags
+ * the renderer uses.
+ *
+ * Works from blank_maze, so whatever the game has written into the
+ * live maze since it was loaded makes no difference.
+ */
+static void paint_level(wall_paint_t* p, int n) {
+    uint16_t* wall  = inside_wall + n * maze_h * (maze_w + 1);
+    int*      stack = p->heap;
+    int       top   = 0;
+    int       i, j, k;
+
+    memset((void*)wall, 0, maze_h * (maze_w + 1) * sizeof(*wall));
+    p->wall       = wall;
+    total_dots[n] = 0;
+    pellets[n]    = 0;
+    for (i = 0; i < maze_h; i++)
+        for (j = 0; j <= maze_w; j++) {
+            long c = maze_visual_of(blank_maze, n, i, j);
+
+            k        = i * (maze_w + 1) + j;
+            p->ud[k] = (unsigned char)udlr[c];
+            if (ISPELLET(c) || ISDOT(c)) {
+                total_dots[n]++;
+                if (ISPELLET(c)) {
+                    pellets[n]++;
                 }
-            } while (!phase_done);
+            }
+            if (ISNONINVERTABLE(c)) {
+                wall[k] |= INSIDE_WALL_NON_INVERTABLE;
+                stack[top++] = k;
+            }
+        }
+    while (top) {
+        int q[5], m;
+
+        k    = stack[--top];
+        i    = k / (maze_w + 1);
+        j    = k % (maze_w + 1);
+        q[0] = YWRAP(i - 1) * (maze_w + 1) + j;
+        q[1] = YWRAP(i + 1) * (maze_w + 1) + j;
+        q[2] = j ? (k - 1) : (i * (maze_w + 1) + maze_w - 1);
+        q[3] = (j < maze_w) ? (k + 1) : k;
+        q[4] = j ? k : (i * (maze_w + 1) + maze_w);
+        for (m = 0; m < 5; m++) {
+            if ((!(wall[q[m]] & INSIDE_WALL_NON_INVERTABLE)) &&
+                (!p->ud[q[m]]) &&
+                next_to_non_invertable(wall, q[m] / (maze_w + 1),
+                                       q[m] % (maze_w + 1))) {
+                wall[q[m]] |= INSIDE_WALL_NON_INVERTABLE;
+                stack[top++] = q[m];
+            }
         }
     }
+    /* a cell's own flags only ever gain bits here, so a cell passed
+     * over can not start a painting later on and one scan will do */
+    for (i = 0; i < maze_h; i++)
+        for (j = 0; j <= maze_w; j++) {
+            k = i * (maze_w + 1) + j;
+            if ((!(wall[k] &
+                   (INSIDE_WALL_NON_INVERTABLE | INSIDE_WALL_PROVISIONAL |
+                    INSIDE_WALL_YES | INSIDE_WALL_NO | INSIDE_WALL_PHASE2))) &&
+                ((((wall[YWRAP(i - 1) * (maze_w + 1) + j] ^
+                    wall[YWRAP(i + 1) * (maze_w + 1) + j]) &
+                   INSIDE_WALL_NON_INVERTABLE) &&
+                  ((p->ud[k] & 0x05) == 0x05)) ||
+                 (((wall[i * (maze_w + 1) + XWRAP2(j - 1)] ^
+                    wall[i * (maze_w + 1) + XWRAP2(j + 1)]) &
+                   INSIDE_WALL_NON_INVERTABLE) &&
+                  ((p->ud[k] & 0x50) == 0x50))))
+                paint_wall(p, i, j, INSIDE_WALL_PHASE2);
+        }
+    for (i = 0; i < maze_h; i++)
+        for (j = 0; j <= maze_w; j++) {
+            k = i * (maze_w + 1) + j;
+            if (!(wall[k] &
+                  (INSIDE_WALL_NON_INVERTABLE | INSIDE_WALL_PROVISIONAL |
+                   INSIDE_WALL_YES | INSIDE_WALL_NO | INSIDE_WALL_PHASE3)))
+                paint_wall(p, i, j, INSIDE_WALL_PHASE3);
+        }
+    for (i = 0; i < maze_h; i++)
+        for (j = 0; j <= maze_w; j++)
+            paint_corners(wall, i, j, p->ud[i * (maze_w + 1) + j]);
+}
+
+/* allocate the scratch space for painting one level */
+static void paint_alloc(wall_paint_t* p) {
+    int cells = maze_h * (maze_w + 1);
+
+    p->ud      = (unsigned char*)malloc(cells * sizeof(*p->ud));
+    p->queued  = (int*)calloc(cells, sizeof(*p->queued));
+    p->heap    = (int*)malloc(cells * sizeof(*p->heap));
+    p->next    = (int*)malloc(cells * sizeof(*p->next));
+    p->painted = (int*)malloc(cells * sizeof(*p->painted));
+    if (!(p->ud && p->queued && p->heap && p->next && p->painted)) {
+        perror("malloc");
+        exit(1);
+    }
+    p->sweep = 0;
+}
+
+static void paint_free(wall_paint_t* p) {
+    free((void*)p->ud);
+    free((void*)p->queued);
+    free((void*)p->heap);
+    free((void*)p->next);
+    free((void*)p->painted);
+}
+
+/* preparation state of each level, see maze_prepare() */
+#define LEVEL_UNPAINTED 0
+#define LEVEL_PAINTING 1
+#define LEVEL_READY 2
+
+static atomic_int*     level_state = NULL;
+static int             level_n     = 0;
+static pthread_mutex_t level_lock  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  level_done  = PTHREAD_COND_INITIALIZER;
+
+/* the prefetch thread, which paints the level after the current one */
+static pthread_cond_t prefetch_cond    = PTHREAD_COND_INITIALIZER;
+static pthread_t      prefetch_thread;
+static int            prefetch_started = 0;
+static int            prefetch_want    = -1; /* level to paint next */
+static int            prefetch_busy    = 0;
+static void (*prefetch_done)(void)     = NULL; /* see paint_walls_then() */
+
+/**
+ * @brief Paint level @p n unless some other thread already has
+ *
+ * @param p Scratch space, or NULL to allocate some if it is needed
+ * @param wait If another thread is painting the level, wait for it
+ */
+static void paint_claim(wall_paint_t* p, int n, int wait) {
+    int state = LEVEL_UNPAINTED;
+
+    if (atomic_compare_exchange_strong(level_state + n, &state,
+                                       LEVEL_PAINTING)) {
+        if (p) {
+            paint_level(p, n);
+        } else {
+            wall_paint_t q;
+
+            paint_alloc(&q);
+            paint_level(&q, n);
+            paint_free(&q);
+        }
+        pthread_mutex_lock(&level_lock);
+        atomic_store(level_state + n, LEVEL_READY);
+        pthread_cond_broadcast(&level_done);
+        pthread_mutex_unlock(&level_lock);
+    } else if (wait && (state == LEVEL_PAINTING)) {
+        pthread_mutex_lock(&level_lock);
+        while (atomic_load(level_state + n) != LEVEL_READY)
+            pthread_cond_wait(&level_done, &level_lock);
+        pthread_mutex_unlock(&level_lock);
+    }
+}
+
+/* forget every level painted so far; waits out the prefetch thread */
+static void level_reset(void) {
+    int n;
+
+    pthread_mutex_lock(&level_lock);
+    prefetch_want = -1;
+    prefetch_done = NULL;
+    while (prefetch_busy)
+        pthread_cond_wait(&level_done, &level_lock);
+    if (level_n < maze_n) {
+        free((void*)level_state);
+        level_state = (atomic_int*)malloc(maze_n * sizeof(*level_state));
+        if (!level_state) {
+            perror("malloc");
+            exit(1);
+        }
+        level_n = maze_n;
+    }
+    for (n = 0; n < maze_n; n++)
+        atomic_init(level_state + n, LEVEL_UNPAINTED);
+    pthread_mutex_unlock(&level_lock);
+}
+
+/* levels shared out among the paint_walls() threads */
+typedef struct {
+    atomic_int next; /* next level nobody has taken yet */
+    atomic_int done; /* levels finished */
+} wall_jobs_t;
+
+/* paint levels until none are left; every level only writes its own
+ * slice of inside_wall and its own total_dots and pellets entries */
+static void* paint_worker(void* arg) {
+    wall_jobs_t* jobs = (wall_jobs_t*)arg;
+    wall_paint_t p;
+    int          n;
+
+    paint_alloc(&p);
+    while ((n = atomic_fetch_add(&jobs->next, 1)) < maze_n) {
+        paint_claim(&p, n, 1);
+        atomic_fetch_add(&jobs->done, 1);
+    }
+    paint_free(&p);
+    return NULL;
+}
+
+/**
+ * @brief Work out the inside of the walls of every level
+ *
+ * Fills inside_wall, total_dots and pellets for all maze_n levels. The
+ * levels do not depend on each other, so they are painted in parallel
+ * by up to one thread per CPU (at most PAINT_MAX_JOBS), the calling
+ * thread included. Tools that look at every level use this; the game
+ * itself uses paint_walls_on_demand().
+ *
+ * @param verbose Show a percentage on stderr while it takes a while
+ */
+void paint_walls(int verbose) {
+    wall_jobs_t  jobs;
+    wall_paint_t p;
+    pthread_t    workers[PAINT_MAX_JOBS - 1];
+    long         cpus;
+    int          n, started, wanted;
+    double       tdt, tdt2;
+    int          tdt_used = 0;
+
+    level_reset();
+    atomic_init(&jobs.next, 0);
+    atomic_init(&jobs.done, 0);
+    cpus   = sysconf(_SC_NPROCESSORS_ONLN);
+    wanted = (int)MIN(MIN((cpus > 0) ? cpus : 1L, (long)PAINT_MAX_JOBS),
+                      (long)MAX(maze_n, 1));
+    for (started = 0; started < wanted - 1; started++) {
+        /* the calling thread paints whatever the others do not */
+        if (pthread_create(workers + started, NULL, paint_worker,
+                           (void*)&jobs))
+            break;
+    }
+    paint_alloc(&p);
+    tdt = doubletime();
+    while ((n = atomic_fetch_add(&jobs.next, 1)) < maze_n) {
+        if ((!nogame) && verbose) {
+            tdt2 = doubletime();
+            if ((tdt2 - tdt) >= 1.0) {
+                tdt      = tdt2;
+                tdt_used = 1;
+                fprintf(stderr, "%3d%%\r",
+                        (int)(atomic_load(&jobs.done) * 100.0 / maze_n + 0.5));
+                fflush(stderr);
+            }
+        }
+        paint_claim(&p, n, 1);
+        atomic_fetch_add(&jobs.done, 1);
+    }
+    paint_free(&p);
+    for (n = 0; n < started; n++) {
+        pthread_join(workers[n], NULL);
+    }
     if (tdt_used) {
         fprintf(stderr, "    \r");
         fflush(stderr);
         tdt_used = 0;
     }
 }
+
+/**
+ * @brief Leave the levels to be painted when they are first played
+ *
+ * Like paint_walls(), but paints nothing yet: maze_prepare() paints
+ * each level the first time it is needed, and has the level after it
+ * painted in the background meanwhile.
+ *
+ * @note Call after init_maze(), and again after loading another maze
+ */
+void paint_walls_on_demand(void) {
+    level_reset();
+}
+
+/**
+ * @brief Mark every level painted without painting any of them
+ *
+ * For when inside_wall, total_dots and pellets have been filled in
+ * already, from the maze cache (see maze_cache_paint()).
+ *
+ * @note Call after init_maze(), and again after loading another maze
+ */
+void paint_walls_loaded(void) {
+    int n;
+
+    level_reset();
+    for (n = 0; n < maze_n; n++)
+        atomic_store(level_state + n, LEVEL_READY);
+}
+
+/* first level not painted yet, or -1 once they all are */
+static int level_unfinished(void) {
+    int n;
+
+    for (n = 0; n < maze_n; n++)
+        if (atomic_load(level_state + n) != LEVEL_READY)
+            return n;
+    return -1;
+}
+
+/* paint whatever level maze_prefetch() asks for, one at a time; when
+ * nothing is asked for, finish the levels for paint_walls_then() */
+static void* prefetch_worker(void* arg) {
+    void (*done)(void);
+    int n;
+
+    (void)arg;
+    pthread_mutex_lock(&level_lock);
+    for (;;) {
+        while ((prefetch_want < 0) && !prefetch_done)
+            pthread_cond_wait(&prefetch_cond, &level_lock);
+        n    = prefetch_want;
+        done = NULL;
+        if ((n < 0) && ((n = level_unfinished()) < 0)) {
+            done          = prefetch_done;
+            prefetch_done = NULL;
+        }
+        prefetch_want = -1;
+        prefetch_busy = 1;
+        pthread_mutex_unlock(&level_lock);
+        if (done)
+            done();
+        else
+            paint_claim(NULL, n, 1);
+        pthread_mutex_lock(&level_lock);
+        prefetch_busy = 0;
+        pthread_cond_broadcast(&level_done);
+    }
+    return NULL;
+}
+
+/* start the prefetch thread unless it is running; call with level_lock
+ * held. Returns zero if it could not be started */
+static int prefetch_start(void) {
+    if (!prefetch_started) {
+        sigset_t all, old;
+
+        /* signals are for the game thread to handle */
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &old);
+        prefetch_started =
+            !pthread_create(&prefetch_thread, NULL, prefetch_worker, NULL);
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+    }
+    return prefetch_started;
+}
+
+/* have the prefetch thread paint level n, starting it if need be; if
+ * it can not be started the level is painted when it is played */
+static void maze_prefetch(int n) {
+    if (atomic_load(level_state + n) != LEVEL_UNPAINTED)
+        return;
+    pthread_mutex_lock(&level_lock);
+    if (prefetch_start()) {
+        prefetch_want = n;
+        pthread_cond_signal(&prefetch_cond);
+    }
+    pthread_mutex_unlock(&level_lock);
+}
+
+/**
+ * @brief Paint levels on demand, and the rest of them in the background
+ *
+ * Like paint_walls_on_demand(), but whenever the prefetch thread has
+ * no level to paint for maze_prepare() it paints the lowest one nobody
+ * has painted yet. Once every level is painted it calls @p done on
+ * that thread, which may then read any level's inside_wall slice,
+ * total_dots and pellets. If no thread can be started, @p done is
+ * never called.
+ *
+ * @note Call after init_maze(), and again after loading another maze
+ * @see maze_cache_paint
+ */
+void paint_walls_then(void (*done)(void)) {
+    level_reset();
+    pthread_mutex_lock(&level_lock);
+    if (prefetch_start()) {
+        prefetch_done = done;
+        pthread_cond_signal(&prefetch_cond);
+    }
+    pthread_mutex_unlock(&level_lock);
+}
+
+/**
+ * @brief Level the game moves on to after level @p n
+ *
+ * The next level wraps around to flip_to, or stays on the last level
+ * with FLIP_LOCK, as in check_level_transition().
+ */
+int maze_level_after(int n) {
+    n = (n + 1) % maze_n;
+    if (!n) {
+        n = flip_to % maze_n;
+    }
+    if (FLIP_LOCK && !n) {
+        n = maze_n - 1;
+    }
+    return n;
+}
+
+/**
+ * @brief Make sure level @p n is painted before it is played
+ *
+ * Paints the level's inside_wall slice, total_dots and pellets on the
+ * calling thread unless that has already happened, waiting instead if
+ * the prefetch thread is busy with it. Then has the level that follows
+ * it painted in the background, so moving on to it does not stall.
+ *
+ * @see paint_walls_on_demand, maze_level_after
+ */
+void maze_prepare(int n) {
+    if (atomic_load(level_state + n) != LEVEL_READY)
+        paint_claim(NULL, n, 1);
+    maze_prefetch(maze_level_after(n));
+}
@@ -24,15 +24,311 @@
  */
 
 #include <curses.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "utils.h"
 #include "globals.h"
 
 extern int location_is_suspect;
 
+/* off-screen copy of what the game last drew in each screen cell, so
+ * cells that come out the same as the previous frame skip curses; it
+ * doubles as video memory for the status area, whose cells are tagged
+ * so they can be blanked without repainting the maze. There is one per
+ * curses screen: whoever calls set_term() points screen_fb at the
+ * screen's own (see glomph-server) */
+typedef struct {
+    unsigned long b;      /* CP437 byte, FB_BLANK or FB_UNKNOWN */
+    unsigned long attrs;  /* attributes it was drawn with */
+    unsigned long stamp;  /* fb_clock when last drawn */
+    int           status; /* last drawn as part of the status area */
+} screen_cell_t;
+
+#define FB_BLANK (~0UL)       /* erased by curses */
+#define FB_UNKNOWN (~0UL - 1) /* drawn behind the framebuffer's back */
+
+struct screen_fb {
+    screen_cell_t* cells;
+    WINDOW*        win;      /* stdscr of the screen it describes */
+    int            lines;
+    int            cols;
+    unsigned long  clock;
+    unsigned long  sweep_to; /* set by screen_fb_erase() */
+    unsigned long  frame;    /* set by screen_fb_frame() */
+    int            status;   /* set by screen_fb_status() */
+};
+
+static screen_fb_t screen_fb_main = {NULL, NULL, 0, 0, 1, 0, 0, 0};
+
+/* like the curses screen it follows, process-wide rather than per
+ * thread */
+screen_fb_t* screen_fb = &screen_fb_main;
+
 int my_clear(void) {
+    int ret;
+
     location_is_suspect = 0;
-    return clear();
+    ret                 = clear();
+    screen_fb_wipe();
+    if (vt_backend)
+        vt_clear();
+    return ret;
+}
+
+/**
+ * @brief Make a framebuffer for another curses screen
+ *
+ * Empty until the first screen_fb_wipe() while it is current.
+ *
+ * @note Exits on allocation failure
+ */
+screen_fb_t* screen_fb_new(void) {
+    screen_fb_t* f = (screen_fb_t*)calloc(1, sizeof(*f));
+
+    if (!f) {
+        perror("calloc");
+        exit(1);
+    }
+    f->clock = 1;
+    return f;
+}
+
+void screen_fb_free(screen_fb_t* f) {
+    if (!f)
+        return;
+    if (screen_fb == f)
+        screen_fb = &screen_fb_main;
+    free((void*)f->cells);
+    free((void*)f);
+}
+
+/**
+ * @brief Note that curses has just erased or cleared the whole screen
+ *
+ * Resizes the framebuffer to the current screen if needed and marks
+ * every cell blank.
+ *
+ * @note Exits on allocation failure
+ */
+void screen_fb_wipe(void) {
+    screen_fb_t* f = screen_fb;
+    int          i;
+
+    if ((f->lines != LINES) || (f->cols != COLS) || !f->cells) {
+        free((void*)f->cells);
+        f->lines = LINES;
+        f->cols  = COLS;
+        f->cells = (screen_cell_t*)malloc(
+            ((size_t)f->lines * f->cols + 1) * sizeof(*f->cells));
+        if (!f->cells) {
+            perror("malloc");
+            exit(1);
+        }
+    }
+    for (i = 0; i < f->lines * f->cols; i++) {
+        f->cells[i].b      = FB_BLANK;
+        f->cells[i].attrs  = 0;
+        f->cells[i].stamp  = 0;
+        f->cells[i].status = 0;
+    }
+    f->win      = stdscr;
+    f->sweep_to = 0;
+    f->frame    = 0;
+}
+
+/* nonzero while the current framebuffer describes stdscr */
+static int screen_fb_valid(void) {
+    screen_fb_t* f = screen_fb;
+
+    return f->cells && (f->win == stdscr) && (f->lines == LINES) &&
+           (f->cols == COLS);
+}
+
+/**
+ * @brief Note that @p n cells from (y, x) were drawn without
+ *        screen_fb_put()
+ */
+void screen_fb_forget(int y, int x, int n) {
+    screen_fb_t* f = screen_fb;
+
+    if ((!screen_fb_valid()) || (y < 0) || (y >= f->lines))
+        return;
+    for (; n > 0; n--, x++) {
+        if ((x >= 0) && (x < f->cols)) {
+            f->cells[y * f->cols + x].b      = FB_UNKNOWN;
+            f->cells[y * f->cols + x].stamp  = f->clock;
+            f->cells[y * f->cols + x].status = f->status;
+        }
+    }
+}
+
+/**
+ * @brief Record a cell about to be drawn
+ *
+ * @param y Screen line
+ * @param x Screen column
+ * @param b CP437 byte
+ * @param attrs Curses attributes
+ * @return Nonzero if the cell already shows @p b with @p attrs, in which
+ *         case drawing it again can be skipped
+ */
+int screen_fb_put(int y, int x, unsigned long b, unsigned long attrs) {
+    screen_fb_t*   f = screen_fb;
+    screen_cell_t* cell;
+
+    if ((!screen_fb_valid()) || (y < 0) || (y >= f->lines) || (x < 0) ||
+        (x >= f->cols))
+        return 0;
+    cell         = f->cells + y * f->cols + x;
+    cell->stamp  = f->clock;
+    cell->status = f->status;
+    if ((cell->b == b) && (cell->attrs == attrs))
+        return 1;
+    cell->b     = b;
+    cell->attrs = attrs;
+    return 0;
+}
+
+/**
+ * @brief Start a frame that repaints every cell without erasing first
+ *
+ * Stands in for erase() before a full repaint: cells drawn again
+ * unchanged cost nothing, and screen_fb_sweep() blanks whatever the
+ * frame did not draw.
+ *
+ * @return 0 if the framebuffer cannot stand in, so erase() is needed
+ */
+int screen_fb_erase(void) {
+    if (!screen_fb_valid())
+        return 0;
+    screen_fb->sweep_to = ++screen_fb->clock;
+    return 1;
+}
+
+/**
+ * @brief Blank the cells not drawn since screen_fb_erase()
+ *
+ * Does nothing unless screen_fb_erase() started the frame.
+ */
+void screen_fb_sweep(void) {
+    screen_fb_t* f = screen_fb;
+    int          i;
+
+    if ((!f->sweep_to) || (!screen_fb_valid())) {
+        f->sweep_to = 0;
+        return;
+    }
+    attrset(0);
+    for (i = 0; i < f->lines * f->cols; i++) {
+        screen_cell_t* cell = f->cells + i;
+
+        if ((cell->stamp < f->sweep_to) && (cell->b != FB_BLANK)) {
+            if (vt_active)
+                vt_put(i / f->cols, i % f->cols, ' ', 0);
+            else
+                mvaddch(i / f->cols, i % f->cols, ' ');
+            cell->b      = FB_BLANK;
+            cell->attrs  = 0;
+            cell->status = 0;
+        }
+    }
+    f->sweep_to = 0;
+}
+
+/**
+ * @brief Start a frame
+ *
+ * Cells drawn from here on count as drawn by this frame for
+ * screen_fb_status_sweep().
+ *
+ * @return 0 if the framebuffer does not describe the screen
+ */
+int screen_fb_frame(void) {
+    if (!screen_fb_valid())
+        return 0;
+    screen_fb->frame = ++screen_fb->clock;
+    return 1;
+}
+
+/**
+ * @brief Tag the cells drawn from now on as status area (or not)
+ *
+ * @param on Nonzero while the score, lives and level icons are drawn
+ */
+void screen_fb_status(int on) {
+    screen_fb->status = on;
+}
+
+/**
+ * @brief Blank the status area cells this frame did not draw again
+ *
+ * Lets a shorter score, a lost life or a changed set of level icons
+ * clear what they left behind without a full repaint.  Does nothing
+ * unless screen_fb_frame() started the frame.
+ */
+void screen_fb_status_sweep(void) {
+    screen_fb_t* f = screen_fb;
+    int          i;
+
+    if ((!f->frame) || (!screen_fb_valid()))
+        return;
+    attrset(0);
+    for (i = 0; i < f->lines * f->cols; i++) {
+        screen_cell_t* cell = f->cells + i;
+
+        if (cell->status && (cell->stamp < f->frame)) {
+            if (cell->b != FB_BLANK) {
+                if (vt_active)
+                    vt_put(i / f->cols, i % f->cols, ' ', 0);
+                else
+                    mvaddch(i / f->cols, i % f->cols, ' ');
+            }
+            cell->b      = FB_BLANK;
+            cell->attrs  = 0;
+            cell->status = 0;
+        }
+    }
+}
+
+/**
+ * @brief Note that lines @p top to @p bot were scrolled up by @p n
+ *
+ * Moves the recorded cells with the text, as wscrl() does (down when
+ * @p n is negative), and marks the lines scrolled in blank.
+ */
+void screen_fb_scroll(int top, int bot, int n) {
+    screen_fb_t*   f = screen_fb;
+    screen_cell_t* row;
+    int            lines, y, y0, y1;
+
+    if ((!screen_fb_valid()) || (top < 0) || (bot >= f->lines) ||
+        (top > bot) || (!n))
+        return;
+    row   = f->cells;
+    lines = bot - top + 1;
+    if ((n >= lines) || (-n >= lines)) {
+        y0 = top;
+        y1 = bot;
+    } else if (n > 0) {
+        memmove((void*)(row + top * f->cols),
+                (void*)(row + (top + n) * f->cols),
+                (size_t)(lines - n) * f->cols * sizeof(*row));
+        y0 = bot - n + 1;
+        y1 = bot;
+    } else {
+        memmove((void*)(row + (top - n) * f->cols),
+                (void*)(row + top * f->cols),
+                (size_t)(lines + n) * f->cols * sizeof(*row));
+        y0 = top;
+        y1 = top - n - 1;
+    }
+    for (y = y0 * f->cols; y < (y1 + 1) * f->cols; y++) {
+        row[y].b      = FB_BLANK;
+        row[y].attrs  = 0;
+        row[y].stamp  = 0;
+        row[y].status = 0;
+    }
 }
 
 void my_clearok(int ok) {
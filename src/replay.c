@@ -0,0 +1,287 @@
+/* replay.c - Deterministic input recording and replay for Glomph Maze
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+#include <curses.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "globals.h"
+#include "utils.h"
+#include "game_context_aliases.h"
+
+#define REPLAY_MAGIC "glomph-replay"
+#define REPLAY_VERSION 1
+
+const char* record_path   = NULL;
+const char* replay_path   = NULL;
+FILE*       record_stream = NULL;
+FILE*       replay_stream = NULL;
+
+int           replay_diverged    = 0;
+unsigned long replay_keys        = 0;
+unsigned long replay_checkpoints = 0;
+
+/* recording interval, and the next unconsumed event of a replay */
+static long     replay_interval = REPLAY_INTERVAL;
+static int      next_type       = 0;
+static long     next_frame      = 0;
+static int      next_key        = ERR;
+static int      next_delay      = 0;
+static uint64_t next_hash       = 0;
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t fnv1a(uint64_t h, const void* data, size_t len) {
+    const unsigned char* p = (const unsigned char*)data;
+
+    while (len--) {
+        h ^= *p++;
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+/**
+ * @brief Identify the maze and options a recording depends on
+ *
+ * Hashes every level of the loaded maze together with the number of
+ * ghosts and starting lives, so a replay against a different maze or
+ * different -g/-l options is rejected up front instead of diverging.
+ */
+uint64_t replay_fingerprint(void) {
+    uint64_t h = FNV_OFFSET;
+    int      g = ghosts;
+
+    h = fnv1a(h, &maze_n, sizeof(maze_n));
+    h = fnv1a(h, &maze_w, sizeof(maze_w));
+    h = fnv1a(h, &maze_h, sizeof(maze_h));
+    h = fnv1a(h, maze, (size_t)maze_n * maze_h * (maze_w + 1));
+    h = fnv1a(h, &g, sizeof(g));
+    h = fnv1a(h, &lives, sizeof(lives));
+    return h;
+}
+
+/**
+ * @brief Hash the simulation state that a checkpoint compares
+ *
+ * Covers all sprite registers, the score, the dot count and the live
+ * maze level. Values are hashed in native byte order, so recordings are
+ * only comparable between builds for the same platform.
+ */
+uint64_t replay_hash(void) {
+    uint64_t h = FNV_OFFSET;
+
+    h = fnv1a(h, sprite_register, sizeof(sprite_register));
+    h = fnv1a(h, sprite_register_frame, sizeof(sprite_register_frame));
+    h = fnv1a(h, sprite_register_x, sizeof(sprite_register_x));
+    h = fnv1a(h, sprite_register_y, sizeof(sprite_register_y));
+    h = fnv1a(h, sprite_register_used, sizeof(sprite_register_used));
+    h = fnv1a(h, sprite_register_timer, sizeof(sprite_register_timer));
+    h = fnv1a(h, sprite_register_color, sizeof(sprite_register_color));
+    h = fnv1a(h, &score, sizeof(score));
+    h = fnv1a(h, &dots, sizeof(dots));
+    h = fnv1a(h, &maze_level, sizeof(maze_level));
+    h = fnv1a(h, maze + (size_t)maze_level * maze_h * (maze_w + 1),
+              (size_t)maze_h * (maze_w + 1));
+    return h;
+}
+
+/**
+ * @brief Start recording to a file
+ *
+ * Must be called after the maze has been loaded, before the first
+ * frame.
+ *
+ * @return 0 on success, 1 if the file could not be created
+ */
+int record_open(const char* path) {
+    record_stream = fopen(path, "w");
+    if (!record_stream) {
+        perror(path);
+        return 1;
+    }
+    fprintf(record_stream, "%s %d %ld %016" PRIx64 "\n", REPLAY_MAGIC,
+            REPLAY_VERSION, replay_interval, replay_fingerprint());
+    return 0;
+}
+
+/**
+ * @brief Finish a recording, marking the frame it ended on
+ */
+void record_close(void) {
+    if (!record_stream)
+        return;
+    fprintf(record_stream, "e %ld\n", frames);
+    if (fclose(record_stream))
+        perror(record_path ? record_path : "fclose");
+    record_stream = NULL;
+}
+
+/* read the next event of the replay into next_*; 0 at end of file */
+static int replay_next(void) {
+    char type;
+
+    next_type = 0;
+    if (fscanf(replay_stream, " %c %ld", &type, &next_frame) != 2)
+        return 0;
+    if (type == 'k') {
+        if (fscanf(replay_stream, "%d %d", &next_key, &next_delay) != 2)
+            return 0;
+    } else if (type == 'h') {
+        if (fscanf(replay_stream, "%" SCNx64, &next_hash) != 1)
+            return 0;
+    } else if (type != 'e') {
+        return 0;
+    }
+    next_type = type;
+    return 1;
+}
+
+/**
+ * @brief Start replaying a recording
+ *
+ * Checks the header against the loaded maze and options. Must be called
+ * after the maze has been loaded, before the first frame.
+ *
+ * @return 0 on success, 1 if the file is unreadable or does not match
+ */
+int replay_open(const char* path) {
+    char     magic[32];
+    int      version;
+    uint64_t fingerprint;
+
+    replay_stream = fopen(path, "r");
+    if (!replay_stream) {
+        perror(path);
+        return 1;
+    }
+    if ((fscanf(replay_stream, "%31s %d %ld %" SCNx64, magic, &version,
+                &replay_interval, &fingerprint) != 4) ||
+        strcmp(magic, REPLAY_MAGIC) || (version != REPLAY_VERSION) ||
+        (replay_interval <= 0)) {
+        fprintf(stderr, "%s: %s: not a replay file\n", progname, path);
+        replay_close();
+        return 1;
+    }
+    if (fingerprint != replay_fingerprint()) {
+        fprintf(stderr,
+                "%s: %s: recorded with a different maze, ghost count or "
+                "number of lives\n",
+                progname, path);
+        replay_close();
+        return 1;
+    }
+    replay_next();
+    return 0;
+}
+
+void replay_close(void) {
+    if (replay_stream)
+        fclose(replay_stream);
+    replay_stream = NULL;
+}
+
+/**
+ * @brief Record or substitute a key read by the game
+ *
+ * Called with the result of every non-blocking key read the game makes
+ * (gameinput() and the pager). When recording, logs the key with the
+ * current frame and ignore_delay, which is the only timing-dependent
+ * state that changes how gameinput() treats a key. When replaying, the
+ * terminal is not read at all: returns the recorded key for this frame,
+ * ERR when there is none, or 'q' once the recording (or the
+ * verification) has ended.
+ *
+ * @param k Key returned by my_getch(), or ERR
+ * @return The key the game should act on
+ */
+int replay_input(int k) {
+    if (record_stream) {
+        if (k != ERR)
+            fprintf(record_stream, "k %ld %d %d\n", frames, k, ignore_delay);
+        return k;
+    }
+    if (!replay_stream)
+        return k;
+    if (replay_diverged || !next_type ||
+        ((next_type == 'e') && (next_frame <= frames)))
+        return 'q';
+    if ((next_type == 'k') && (next_frame < frames)) {
+        fprintf(stderr, "%s: replay diverged: key recorded at frame %ld "
+                        "was not read\n",
+                progname, next_frame);
+        replay_diverged = 1;
+        return 'q';
+    }
+    if ((next_type != 'k') || (next_frame != frames))
+        return ERR;
+    k            = next_key;
+    ignore_delay = next_delay;
+    replay_keys++;
+    replay_next();
+    return k;
+}
+
+/**
+ * @brief Write or verify the state hash for the current frame
+ *
+ * Called by gametick() once per frame; does nothing unless recording
+ * or replaying.
+ */
+void replay_checkpoint(void) {
+    uint64_t h;
+
+    if (record_stream) {
+        if (!(frames % replay_interval))
+            fprintf(record_stream, "h %ld %016" PRIx64 "\n", frames,
+                    replay_hash());
+        return;
+    }
+    if (!replay_stream || replay_diverged || (next_type != 'h'))
+        return;
+    if (next_frame < frames) {
+        fprintf(stderr, "%s: replay diverged: checkpoint at frame %ld was "
+                        "never reached\n",
+                progname, next_frame);
+        replay_diverged = 1;
+        return;
+    }
+    if (next_frame != frames)
+        return;
+    h = replay_hash();
+    if (h != next_hash) {
+        fprintf(stderr,
+                "%s: replay diverged at frame %ld: state hash %016" PRIx64
+                ", recorded %016" PRIx64 "\n",
+                progname, frames, h, next_hash);
+        replay_diverged = 1;
+        return;
+    }
+    replay_checkpoints++;
+    replay_next();
+}
@@ -0,0 +1,751 @@
+/* server.c - Multi-session terminal server for Glomph Maze
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * glomph-server hosts many games in one process. Each client that
+ * connects to a Unix domain socket gets its own game_context_t (cloned
+ * from the freshly loaded game_main) and its own curses SCREEN with the
+ * framebuffer that goes with it (screen_fb), while the tiles, sprites
+ * and blank maze stay shared and read-only.
+ *
+ * One epoll loop serves every session. A timerfd wakes it every
+ * SERVER_QUANTUM_USEC; each wakeup steps every session whose frame is
+ * due with gamestep(), so ticks are batched across sessions instead of
+ * each game sleeping in gamecycle().
+ *
+ * curses draws each session into a memfd, a file in memory that grows
+ * as needed, so a frame of any size is written without blocking. After
+ * every frame the server moves it into a per-session buffer and copies
+ * that to the client without blocking; a client that falls
+ * SERVER_BACKLOG bytes behind keeps playing but stops being drawn until
+ * it catches up, and one that would fall SERVER_BACKLOG_MAX behind is
+ * dropped.
+ *
+ * Clients are plain terminals, e.g.
+ *     socat -,raw,echo=0 UNIX-CONNECT:glomph.sock
+ */
+
+#define _GNU_SOURCE /* memfd_create */
+
+#include <curses.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <locale.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "globals.h"
+#include "utils.h"
+
+#ifndef SERVER_SOCKET
+#define SERVER_SOCKET "glomph.sock"
+#endif
+
+#ifndef SERVER_MAX_SESSIONS
+#define SERVER_MAX_SESSIONS 1024
+#endif
+
+/* timer granularity; session frames are rounded up to a multiple */
+#ifndef SERVER_QUANTUM_USEC
+#define SERVER_QUANTUM_USEC 5000L
+#endif
+
+/* queued output above which a session's frames are simulated only */
+#ifndef SERVER_BACKLOG
+#define SERVER_BACKLOG 65536UL
+#endif
+
+/* queued output above which a session is disconnected */
+#ifndef SERVER_BACKLOG_MAX
+#define SERVER_BACKLOG_MAX (4UL << 20)
+#endif
+
+/* keys a session may have queued between two of its frames */
+#ifndef SERVER_KEYS
+#define SERVER_KEYS 32
+#endif
+
+#define SERVER_EVENTS 64
+
+typedef struct {
+    int             fd;       /**< client connection */
+    FILE*           term_in;  /**< /dev/null; curses never reads keys */
+    FILE*           term_out; /**< memfd curses draws the frame into */
+    SCREEN*         screen;
+    screen_fb_t*    fb;       /**< what screen shows, see render_state.c */
+    game_context_t* ctx;
+    double          due;      /**< doubletime() of the next frame */
+    char*           out;      /**< output not yet accepted by the client */
+    size_t          out_len;
+    size_t          out_size;
+    int             keys[SERVER_KEYS]; /**< queued keys, see session_getch */
+    size_t          first_key;
+    size_t          n_keys;
+    int             escape;   /**< escape sequence state, see session_input */
+    int             stale;    /**< frames were skipped; redraw everything */
+    int             writable; /**< waiting for EPOLLOUT */
+} session_t;
+
+static const char*   listen_path  = SERVER_SOCKET;
+static const char*   term_name    = NULL;
+static unsigned long max_sessions = SERVER_MAX_SESSIONS;
+
+static int         epoll_fd   = -1;
+static int         listen_fd  = -1;
+static int         timer_fd   = -1;
+static session_t** sessions   = NULL;
+static size_t      n_sessions = 0;
+static session_t** idle       = NULL; /* closed sessions, screens kept */
+static size_t      n_idle     = 0;
+
+/* frames rendered for all sessions, reported at exit with
+ * full_repaints */
+static unsigned long frames_drawn = 0;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void server_usage(void) {
+    printf("Usage: %s [--listen PATH] [--max-sessions N] [--term NAME] "
+           "[glomph options]\n",
+           progname);
+    printf("--listen PATH \taccept players on Unix socket PATH "
+           "(default %s)\n",
+           SERVER_SOCKET);
+    printf("--max-sessions N \tallow at most N concurrent games "
+           "(default %lu)\n",
+           (unsigned long)SERVER_MAX_SESSIONS);
+    puts("--term NAME \tterminal type of the clients (default $TERM)");
+    puts("--help \tdisplay this help and exit");
+    puts("Other options select the maze, size and game settings as for "
+         "glomph.");
+    printf("Connect with e.g.: socat -,raw,echo=0 UNIX-CONNECT:%s\n",
+           SERVER_SOCKET);
+}
+
+static void stop_handler(int signum) {
+    (void)signum;
+    stop_requested = 1;
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+
+    return (flags == -1) ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/* remove --listen, --max-sessions and --term from argv; returns the new
+ * argc, or -1 after printing a diagnostic */
+static int parse_server_args(int argc, char* argv[]) {
+    int i, j;
+
+    for (i = j = 1; i < argc; i++) {
+        const char* names[] = {"--listen", "--max-sessions", "--term"};
+        const char* value   = NULL;
+        size_t      k, len;
+
+        for (k = 0; k < sizeof(names) / sizeof(*names); k++) {
+            len = strlen(names[k]);
+            if (!strncmp(argv[i], names[k], len) &&
+                ((argv[i][len] == '=') || !argv[i][len]))
+                break;
+        }
+        if (k == sizeof(names) / sizeof(*names)) {
+            argv[j++] = argv[i];
+            continue;
+        }
+        if (argv[i][len] == '=') {
+            value = argv[i] + len + 1;
+        } else if (i + 1 < argc) {
+            value = argv[++i];
+        } else {
+            fprintf(stderr, "%s: %s requires an argument\n", progname,
+                    names[k]);
+            return -1;
+        }
+        if (k == 0) {
+            listen_path = value;
+        } else if (k == 1) {
+            char garbage;
+
+            if ((sscanf(value, "%lu%c", &max_sessions, &garbage) != 1) ||
+                !max_sessions) {
+                fprintf(stderr,
+                        "%s: argument to --max-sessions must be a positive "
+                        "integer.\n",
+                        progname);
+                return -1;
+            }
+        } else {
+            term_name = value;
+        }
+    }
+    argv[j] = NULL;
+    return j;
+}
+
+static int listen_unix(const char* path) {
+    struct sockaddr_un addr;
+    int                fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "%s: socket path too long: %s\n", progname, path);
+        return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        perror("socket");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) ||
+        listen(fd, SOMAXCONN) || set_nonblocking(fd)) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* seconds until the current session's next frame, as gamecycle() would
+ * pace it */
+static double session_delay(void) {
+    if (game_ctx->myman_demo_setup)
+        return 0.0;
+    return 1e-6 * (double)(game_ctx->myman_demo
+                               ? ((game_ctx->mymandelay + mindelay) / 2)
+                               : game_ctx->mymandelay);
+}
+
+/* make s's screen, and its framebuffer, the one curses draws on */
+static void session_select(session_t* s) {
+    set_term(s->screen);
+    screen_fb = s->fb;
+}
+
+/* empty the frame file for the next frame, or the next connection */
+static void session_rewind(session_t* s) {
+    int frame = fileno(s->term_out);
+
+    if (ftruncate(frame, 0) || (lseek(frame, 0, SEEK_SET) == -1))
+        perror("ftruncate");
+}
+
+/* end a session: the connection and the game go away, the curses
+ * screen is kept for the next connection (see session_open) */
+static void session_close(session_t* s) {
+    size_t i;
+
+    session_select(s);
+    endwin();
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    game_context_free(s->ctx);
+    session_rewind(s);
+    s->fd        = -1;
+    s->ctx       = NULL;
+    s->out_len   = 0;
+    s->first_key = 0;
+    s->n_keys    = 0;
+    s->escape    = 0;
+    s->stale     = 0;
+    s->writable  = 0;
+    for (i = 0; i < n_sessions; i++) {
+        if (sessions[i] == s) {
+            sessions[i] = sessions[--n_sessions];
+            break;
+        }
+    }
+    idle[n_idle++] = s;
+}
+
+/* move the frame curses drew into the session buffer, then as much of
+ * the buffer to the client as it will take without blocking; returns 0
+ * if the client is gone or would fall SERVER_BACKLOG_MAX behind */
+static int session_flush(session_t* s) {
+    int   frame = fileno(s->term_out);
+    off_t got;
+
+    fflush(s->term_out);
+    got = lseek(frame, 0, SEEK_CUR);
+    if (got > 0) {
+        size_t need = s->out_len + (size_t)got;
+
+        if (need > SERVER_BACKLOG_MAX)
+            return 0;
+        if (need > s->out_size) {
+            size_t size = s->out_size ? s->out_size : 16384;
+            char*  tmp;
+
+            while (size < need)
+                size *= 2;
+            tmp = (char*)realloc(s->out, size);
+            if (!tmp) {
+                perror("realloc");
+                return 0;
+            }
+            s->out      = tmp;
+            s->out_size = size;
+        }
+        if (pread(frame, s->out + s->out_len, (size_t)got, 0) != got) {
+            perror("pread");
+            return 0;
+        }
+        s->out_len = need;
+        session_rewind(s);
+    }
+    while (s->out_len) {
+        ssize_t put = write(s->fd, s->out, s->out_len);
+
+        if (put > 0) {
+            memmove(s->out, s->out + put, s->out_len - (size_t)put);
+            s->out_len -= (size_t)put;
+        } else if ((put == -1) && (errno == EINTR)) {
+            continue;
+        } else if ((put == -1) &&
+                   ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+            break;
+        } else {
+            return 0;
+        }
+    }
+    if (s->writable != (s->out_len != 0)) {
+        struct epoll_event ev;
+
+        s->writable = (s->out_len != 0);
+        ev.events   = EPOLLIN | (s->writable ? EPOLLOUT : 0);
+        ev.data.ptr = s;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, s->fd, &ev);
+    }
+    return 1;
+}
+
+/* keys that change process-wide settings, open files or start the
+ * pager would reach every session, so they are not passed on */
+static int session_key_allowed(unsigned char c) {
+    /* ^H and DEL also open the help pager */
+    if ((c == 0x08) || (c == 0x7f))
+        return 0;
+    return !c || !strchr("tT!?@dDcCbBuUsSoO0aAxXeEiI/\\", c);
+}
+
+static void session_push_key(session_t* s, int k) {
+    if (s->n_keys < SERVER_KEYS) {
+        s->keys[(s->first_key + s->n_keys) % SERVER_KEYS] = k;
+        s->n_keys++;
+    }
+}
+
+/* decode client keystrokes into the session's key queue; cursor keys
+ * arrive as ANSI escape sequences, anything after ESC that is not one
+ * is a lone ESC (pause) followed by ordinary keys */
+static int session_input(session_t* s) {
+    unsigned char buf[256];
+    ssize_t       got, i;
+
+    got = read(s->fd, buf, sizeof(buf));
+    if (got == 0)
+        return 0;
+    if (got < 0)
+        return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+    for (i = 0; i < got; i++) {
+        unsigned char c = buf[i];
+
+        if (s->escape == 2) {
+            if ((c < 0x40) || (c > 0x7e))
+                continue;
+            s->escape = 0;
+            if (c == 'A')
+                session_push_key(s, KEY_UP);
+            else if (c == 'B')
+                session_push_key(s, KEY_DOWN);
+            else if (c == 'C')
+                session_push_key(s, KEY_RIGHT);
+            else if (c == 'D')
+                session_push_key(s, KEY_LEFT);
+            continue;
+        }
+        if (s->escape == 1) {
+            s->escape = 0;
+            if ((c == '[') || (c == 'O')) {
+                s->escape = 2;
+                continue;
+            }
+            session_push_key(s, 27);
+        }
+        if (c == 27)
+            s->escape = 1;
+        else if (session_key_allowed(c))
+            session_push_key(s, c);
+    }
+    return 1;
+}
+
+/* session whose game is being stepped, for session_getch() */
+static session_t* current = NULL;
+
+/* my_getch() for server sessions: the next queued key, or ERR */
+static int session_getch(void) {
+    int k;
+
+    if (!current || !current->n_keys)
+        return ERR;
+    k                  = current->keys[current->first_key];
+    current->first_key = (current->first_key + 1) % SERVER_KEYS;
+    current->n_keys--;
+    return k;
+}
+
+/* a curses screen drawing into a fresh memfd, not yet attached to a
+ * connection */
+static session_t* session_new(void) {
+    session_t* s;
+    int        frame;
+
+    s = (session_t*)calloc(1, sizeof(*s));
+    if (!s) {
+        perror("calloc");
+        return NULL;
+    }
+    s->fd       = -1;
+    frame       = memfd_create("glomph-frame", MFD_CLOEXEC);
+    s->term_out = (frame == -1) ? NULL : fdopen(frame, "w");
+    if (!s->term_out) {
+        perror("memfd_create");
+        if (frame != -1)
+            close(frame);
+        free(s);
+        return NULL;
+    }
+    s->term_in = fopen("/dev/null", "r");
+    if (!s->term_in) {
+        perror("/dev/null");
+        fclose(s->term_out);
+        free(s);
+        return NULL;
+    }
+    s->screen = newterm((char*)term_name, s->term_out, s->term_in);
+    if (!s->screen) {
+        fprintf(stderr, "%s: newterm failed for terminal type `%s'\n",
+                progname, term_name);
+        fclose(s->term_in);
+        fclose(s->term_out);
+        free(s);
+        return NULL;
+    }
+    s->fb = screen_fb_new();
+    session_select(s);
+#ifdef NCURSES_VERSION
+    use_default_colors();
+#endif
+    /* keys come from session_getch(), never from curses */
+    typeahead(-1);
+    return s;
+}
+
+/* start a game for a new connection; takes ownership of fd
+ *
+ * Screens of finished sessions are reused rather than deleted: newterm()
+ * is most of the cost of a connection, and ncurses 6.4 crashes in
+ * init_pair() on a live screen once any other screen has been through
+ * delscreen(). */
+static session_t* session_open(int fd) {
+    session_t*         s;
+    struct epoll_event ev;
+
+    s = n_idle ? idle[--n_idle] : session_new();
+    if (!s || set_nonblocking(fd)) {
+        if (s)
+            idle[n_idle++] = s;
+        close(fd);
+        return NULL;
+    }
+    session_select(s);
+    clearok(curscr, TRUE);
+    myman_screen_init();
+    s->fd  = fd;
+    s->ctx = game_context_clone(&game_main);
+    s->due = doubletime();
+
+    ev.events   = EPOLLIN;
+    ev.data.ptr = s;
+    sessions[n_sessions++] = s;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev)) {
+        perror("epoll_ctl");
+        session_close(s);
+        return NULL;
+    }
+    return s;
+}
+
+static void server_accept(void) {
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+
+        if (fd == -1) {
+            if (errno == EINTR)
+                continue;
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+                perror("accept");
+            return;
+        }
+        if (n_sessions >= max_sessions) {
+            static const char full[] = "glomph-server: server full\r\n";
+
+            if (write(fd, full, sizeof(full) - 1) == -1) {
+                /* nothing more to tell a client we are refusing */
+            }
+            close(fd);
+            continue;
+        }
+        session_open(fd);
+    }
+}
+
+/* run every session whose frame is due, one after another */
+static void server_tick(void) {
+    double now = doubletime();
+    size_t i   = 0;
+
+    while (i < n_sessions) {
+        session_t* s = sessions[i];
+        int        render;
+        int        ret;
+
+        if (s->due > now) {
+            i++;
+            continue;
+        }
+        session_select(s);
+        current = s;
+        /* an ESC with nothing after it by now was pressed on its own */
+        if (s->escape == 1) {
+            s->escape = 0;
+            session_push_key(s, 27);
+        }
+        render = (s->out_len < SERVER_BACKLOG);
+        frames_drawn += (unsigned long)render;
+        if (render && s->stale) {
+            /* what DIRTY_ALL() does, for a context that is not current */
+            s->ctx->all_dirty = 1;
+            s->stale          = 0;
+        }
+        ret     = gamestep(s->ctx, LINES, COLS, render);
+        current = NULL;
+        s->stale |= !render;
+        s->due += session_delay();
+        /* fall behind rather than replay a burst of missed frames */
+        if (s->due < now)
+            s->due = now;
+        if (!ret)
+            myman_screen_done();
+        if (!session_flush(s) || !ret) {
+            session_close(s);
+            continue;
+        }
+        i++;
+    }
+}
+
+static int server_run(void) {
+    struct epoll_event ev;
+    struct itimerspec  its;
+
+    epoll_fd  = epoll_create1(0);
+    timer_fd  = timerfd_create(CLOCK_MONOTONIC, 0);
+    listen_fd = listen_unix(listen_path);
+    if ((epoll_fd == -1) || (timer_fd == -1)) {
+        perror("epoll");
+        return 1;
+    }
+    if (listen_fd == -1)
+        return 1;
+    set_nonblocking(timer_fd);
+    memset(&its, 0, sizeof(its));
+    its.it_interval.tv_nsec = SERVER_QUANTUM_USEC * 1000L;
+    its.it_value            = its.it_interval;
+    if (timerfd_settime(timer_fd, 0, &its, NULL)) {
+        perror("timerfd_settime");
+        return 1;
+    }
+    ev.events   = EPOLLIN;
+    ev.data.ptr = &listen_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+    ev.data.ptr = &timer_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev);
+    fprintf(stderr, "%s: listening on %s\n", progname, listen_path);
+
+    while (!stop_requested) {
+        struct epoll_event events[SERVER_EVENTS];
+        int                n, i;
+
+        n = epoll_wait(epoll_fd, events, SERVER_EVENTS, -1);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (i = 0; i < n; i++) {
+            void* ptr = events[i].data.ptr;
+
+            if (ptr == &listen_fd) {
+                server_accept();
+            } else if (ptr == &timer_fd) {
+                uint64_t expirations;
+
+                if (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+                    server_tick();
+            } else {
+                session_t* s  = (session_t*)ptr;
+                int        ok = 1;
+                size_t     j;
+
+                /* an earlier event in this batch may have closed it */
+                for (j = 0; (j < n_sessions) && (sessions[j] != s); j++)
+                    ;
+                if (j == n_sessions)
+                    continue;
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                    ok = 0;
+                if (ok && (events[i].events & EPOLLIN))
+                    ok = session_input(s);
+                if (ok && (events[i].events & EPOLLOUT))
+                    ok = session_flush(s);
+                if (!ok)
+                    session_close(s);
+            }
+        }
+    }
+    while (n_sessions) {
+        session_select(sessions[0]);
+        myman_screen_done();
+        session_flush(sessions[0]);
+        session_close(sessions[0]);
+    }
+    close(listen_fd);
+    unlink(listen_path);
+    fprintf(stderr, "%s: %lu frames drawn, %lu full repaints\n", progname,
+            frames_drawn, full_repaints);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int  i;
+    long c = 0;
+    char buf[32];
+
+    progname = (argc > 0) ? argv[0] : "glomph-server";
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--help")) {
+            server_usage();
+            return 0;
+        }
+    }
+    argc = parse_server_args(argc, argv);
+    if (argc < 0)
+        return 2;
+    td = 0.0L;
+    for (i = 0; i < SPRITE_REGISTERS; i++) {
+        game_ctx->sprite_register_used[i]  = 0;
+        game_ctx->sprite_register_frame[i] = 0;
+        game_ctx->sprite_register_color[i] = 0x7;
+    }
+    for (i = 0; i < 256; i++) {
+        tile_color[i]   = 0x7;
+        sprite_color[i] = 0x7;
+    }
+    parse_myman_args(argc, argv);
+    /* sessions draw through their own curses screens, not stdout */
+    vt_backend = 0;
+    for (i = 0; i < 256; i++) {
+        int c_mapped;
+
+        c        = (unsigned long)(unsigned char)cp437_sprite[i];
+        c_mapped = c;
+        while (c_mapped && (!tile_used[c_mapped]) &&
+               (((int)(unsigned)fallback_cp437[c_mapped]) != c) &&
+               (((int)(unsigned)fallback_cp437[c_mapped]) != c_mapped)) {
+            c_mapped = (unsigned long)(unsigned char)fallback_cp437[c_mapped];
+            cp437_sprite[i] = (unsigned char)c_mapped;
+        }
+    }
+    if (nogame)
+        return 0;
+    if (!setlocale(LC_CTYPE, "")) {
+        fprintf(stderr, "warning: setlocale(LC_CTYPE, \"\") failed\n");
+    }
+    if (use_fullwidth) {
+        uni_cp437 = uni_cp437_fullwidth;
+    }
+
+    /* every session gets a terminal just big enough for the maze */
+    sprintf(buf, "%d",
+            (reflect ? (maze_w * gfx_w) : (maze_h * gfx_h)) +
+                (3 * tile_h + sprite_h));
+    myman_setenv("LINES", buf);
+    sprintf(buf, "%d",
+            (reflect ? (maze_h * gfx_h) : (maze_w * gfx_w)) *
+                (use_fullwidth ? 2 : 1));
+    myman_setenv("COLUMNS", buf);
+    if (!term_name) {
+        term_name = myman_getenv("TERM");
+        if (!term_name || !*term_name)
+            term_name = "xterm";
+    }
+
+    sessions = (session_t**)calloc(max_sessions, sizeof(*sessions));
+    idle     = (session_t**)calloc(max_sessions, sizeof(*idle));
+    if (!sessions || !idle) {
+        perror("calloc");
+        return 1;
+    }
+    /* a session holds three descriptors: the client, its frame and
+     * /dev/null */
+    {
+        struct rlimit rl;
+
+        if (!getrlimit(RLIMIT_NOFILE, &rl) && (rl.rlim_cur < rl.rlim_max)) {
+            rl.rlim_cur = rl.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &rl);
+        }
+    }
+    getch_hook = session_getch;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, stop_handler);
+    signal(SIGTERM, stop_handler);
+    return server_run();
+}
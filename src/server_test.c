@@ -0,0 +1,286 @@
+/* server_test.c - Client test for the Glomph Maze game server
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * glomph-server-test starts glomph-server on a socket in the current
+ * directory and connects one client that never reads, and players that
+ * start a game, steer the hero and must keep getting frames for
+ * TEST_SECONDS. Starting the game draws the whole maze at once, the
+ * largest frame there is. The server is then stopped with SIGTERM and
+ * has to exit cleanly.
+ *
+ * This is done with one player and again with TEST_PLAYERS. They all
+ * press the same keys, so each game scores the same dots and goes
+ * through the same status changes (score reset, lives, level). Every
+ * session has its own framebuffer, so those changes are drawn without
+ * full repaints, and TEST_PLAYERS games must not cost more full
+ * repaints than TEST_PLAYERS times one game, as counted by the server.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef TEST_SOCKET
+#define TEST_SOCKET "server_test.sock"
+#endif
+
+#ifndef TEST_SECONDS
+#define TEST_SECONDS 6
+#endif
+
+#ifndef TEST_PLAYERS
+#define TEST_PLAYERS 3
+#endif
+
+/* keys sent to every player two seconds in, one every half second */
+#define TEST_STEERING "hkljhkljhj"
+
+static const char* progname = "glomph-server-test";
+static pid_t       server   = -1;
+static char**      server_args;
+
+static void fail(const char* what) {
+    fprintf(stderr, "%s: %s\n", progname, what);
+    if (server != -1) {
+        kill(server, SIGKILL);
+        waitpid(server, NULL, 0);
+    }
+    unlink(TEST_SOCKET);
+    exit(1);
+}
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+/* connect to the server, waiting up to ten seconds for it to listen */
+static int connect_server(void) {
+    struct sockaddr_un    addr;
+    const struct timespec pause = {0, 100000000L};
+    int                   tries;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, TEST_SOCKET);
+    for (tries = 0; tries < 100; tries++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (fd == -1)
+            fail("socket failed");
+        if (!connect(fd, (struct sockaddr*)&addr, sizeof(addr)))
+            return fd;
+        close(fd);
+        if (waitpid(server, NULL, WNOHANG) == server) {
+            server = -1;
+            fail("server exited before accepting a connection");
+        }
+        nanosleep(&pause, NULL);
+    }
+    fail("server never accepted a connection");
+    return -1;
+}
+
+/* start the server with its stderr on a pipe; returns the read end */
+static int start_server(void) {
+    int pipefd[2];
+
+    unlink(TEST_SOCKET);
+    if (pipe(pipefd)) {
+        perror("pipe");
+        exit(1);
+    }
+    server = fork();
+    if (server == -1) {
+        perror("fork");
+        exit(1);
+    }
+    if (!server) {
+        dup2(pipefd[1], 2);
+        close(pipefd[0]);
+        close(pipefd[1]);
+        execv(server_args[0], server_args);
+        perror(server_args[0]);
+        _exit(1);
+    }
+    close(pipefd[1]);
+    return pipefd[0];
+}
+
+/* stop the server; returns the full repaints it reports at exit */
+static unsigned long stop_server(int err) {
+    char          report[4096];
+    char*         line;
+    size_t        len = 0;
+    ssize_t       got;
+    unsigned long drawn, repaints;
+    int           status;
+
+    kill(server, SIGTERM);
+    if ((waitpid(server, &status, 0) != server) || !WIFEXITED(status) ||
+        WEXITSTATUS(status)) {
+        server = -1;
+        fail("server did not exit cleanly");
+    }
+    server = -1;
+    while ((len < sizeof(report) - 1) &&
+           ((got = read(err, report + len, sizeof(report) - 1 - len)) > 0))
+        len += (size_t)got;
+    report[len] = '\0';
+    close(err);
+    fputs(report, stderr);
+    for (line = strtok(report, "\n"); line; line = strtok(NULL, "\n")) {
+        const char* colon = strrchr(line, ':');
+
+        if (colon && (sscanf(colon, ": %lu frames drawn, %lu full repaints",
+                             &drawn, &repaints) == 2))
+            return repaints;
+    }
+    fail("server did not report its full repaints");
+    return 0;
+}
+
+/* play the same game in @p players sessions next to an idle one;
+ * returns the number of full repaints */
+static unsigned long play(int players) {
+    char          buf[65536];
+    unsigned long early[TEST_PLAYERS] = {0}, late[TEST_PLAYERS] = {0};
+    int           fds[TEST_PLAYERS];
+    double        start;
+    size_t        keys = 0;
+    unsigned long repaints;
+    int           idle_fd, err, i;
+
+    err = start_server();
+    /* connected first, so the server always has a session to skip */
+    idle_fd = connect_server();
+    for (i = 0; i < players; i++)
+        fds[i] = connect_server();
+    start = now();
+    while (now() - start < TEST_SECONDS) {
+        struct pollfd pfd[TEST_PLAYERS];
+        char          key = 0;
+
+        /* the first key skips the intro to the credit screen, the second
+         * starts the game; each needs a frame of its own */
+        if ((keys < 2) && (now() - start >= 0.5 * (keys + 1)))
+            key = ' ';
+        else if ((keys >= 2) && (keys - 2 < sizeof(TEST_STEERING) - 1) &&
+                 (now() - start >= 0.5 * (keys + 2)))
+            key = TEST_STEERING[keys - 2];
+        if (key) {
+            for (i = 0; i < players; i++)
+                if (write(fds[i], &key, 1) != 1)
+                    fail("write failed");
+            keys++;
+        }
+        for (i = 0; i < players; i++) {
+            pfd[i].fd     = fds[i];
+            pfd[i].events = POLLIN;
+        }
+        if (poll(pfd, (nfds_t)players, 100) <= 0)
+            continue;
+        for (i = 0; i < players; i++) {
+            ssize_t got;
+
+            if (!(pfd[i].revents & (POLLIN | POLLHUP)))
+                continue;
+            got = read(fds[i], buf, sizeof(buf));
+            if (got == 0)
+                fail("server closed the connection");
+            if (got < 0) {
+                if (errno == EINTR)
+                    continue;
+                fail("read failed");
+            }
+            if (now() - start < 1.0)
+                early[i] += (unsigned long)got;
+            else if (now() - start >= TEST_SECONDS - 1.0)
+                late[i] += (unsigned long)got;
+        }
+    }
+    for (i = 0; i < players; i++) {
+        if (!early[i])
+            fail("no frame in the first second");
+        if (!late[i])
+            fail("no frame in the last second");
+    }
+    repaints = stop_server(err);
+    while (players--)
+        close(fds[players]);
+    close(idle_fd);
+    return repaints;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long one, many;
+    int           i;
+
+    if (argc > 0)
+        progname = argv[0];
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s SERVER [glomph-server options]\n",
+                progname);
+        return 2;
+    }
+    server_args = (char**)calloc((size_t)argc + 5, sizeof(*server_args));
+    if (!server_args) {
+        perror("calloc");
+        return 1;
+    }
+    server_args[0] = argv[1];
+    server_args[1] = "--listen";
+    server_args[2] = TEST_SOCKET;
+    server_args[3] = "--term";
+    server_args[4] = "xterm";
+    for (i = 2; i < argc; i++)
+        server_args[i + 3] = argv[i];
+
+    one  = play(1);
+    many = play(TEST_PLAYERS);
+    if (many > TEST_PLAYERS * one) {
+        fprintf(stderr,
+                "%s: %lu full repaints for %d games, %lu for one: sessions "
+                "repaint over each other\n",
+                progname, many, TEST_PLAYERS, one);
+        return 1;
+    }
+    printf("%s: frames received; %lu full repaints for one game, %lu for "
+           "%d\n",
+           progname, one, many, TEST_PLAYERS);
+    return 0;
+}
@@ -0,0 +1,358 @@
+/* sim.c - Parallel headless game simulator for Glomph Maze
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * glomph-sim plays many complete games per maze with the attract-mode
+ * autopilot (gamepilot()) and no terminal at all, and writes one CSV row
+ * per maze with the aggregate score, survival time, dots cleared and
+ * simulation throughput.
+ *
+ * Each game gets its own game_context_t and its own autopilot seed, so
+ * games are independent and run on a pool of worker threads that take
+ * the next unplayed game from a shared counter until none are left.
+ * Results are stored per game and summed in game order afterwards, so
+ * the output depends only on the seed, not on the number of threads.
+ *
+ * Mazes, fonts and the tables derived from them are global, so every
+ * maze is simulated in its own forked child, as in glomph-bench.
+ */
+
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "globals.h"
+#include "utils.h"
+
+#ifndef TILEFILE
+#define TILEFILE TILEDIR "/chr5x2.txt"
+#endif
+
+#ifndef SPRITEFILE
+#define SPRITEFILE SPRITEDIR "/spr7x3.txt"
+#endif
+
+#ifndef MAZEFILE
+#define MAZEFILE MAZEDIR "/maze.txt"
+#endif
+
+#ifndef SIM_GAMES
+#define SIM_GAMES 100UL
+#endif
+
+#ifndef SIM_MAX_TICKS
+#define SIM_MAX_TICKS 1000000UL
+#endif
+
+/* the maximum number of worker threads */
+#define SIM_MAX_JOBS 1024UL
+
+/* outcome of one simulated game */
+typedef struct {
+    unsigned long played;      /**< ticks from the start to game over */
+    unsigned long eaten;       /**< dots and pellets eaten, all levels */
+    long          final_score; /**< score at game over */
+    int           final_level; /**< last level reached, counting from 1 */
+    int           capped;      /**< stopped at max_ticks, still alive */
+} sim_game_t;
+
+static sim_game_t*   games     = NULL;
+static unsigned long n_games   = SIM_GAMES;
+static unsigned long max_ticks = SIM_MAX_TICKS;
+static uint32_t      base_seed = 1;
+static atomic_ulong  next_game;
+
+static const struct option sim_options[] = {
+    {"jobs", required_argument, NULL, 'j'},
+    {"games", required_argument, NULL, 'n'},
+    {"seed", required_argument, NULL, 's'},
+    {"max-ticks", required_argument, NULL, 't'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}};
+
+static void sim_usage(void) {
+    printf("Usage: %s [-j JOBS] [-n GAMES] [-s SEED] [-t TICKS] [MAZE...]\n",
+           progname);
+    puts("-j NUM, --jobs=NUM \trun NUM games at a time (default: one per "
+         "CPU)");
+    printf("-n NUM, --games=NUM \tplay NUM games per maze (default %lu)\n",
+           (unsigned long)SIM_GAMES);
+    puts("-s NUM, --seed=NUM \tseed of the first game; game i uses SEED + i "
+         "(default 1,\n\t\t\tseed 0 is the unseeded attract-mode pilot)");
+    printf("-t NUM, --max-ticks=NUM \tgive up on a game after NUM ticks "
+           "(default %lu)\n",
+           (unsigned long)SIM_MAX_TICKS);
+    puts("-h, --help \tdisplay this help and exit");
+    printf("Without MAZE arguments %s is simulated.\n", MAZEFILE);
+}
+
+/* parse an unsigned option argument, exiting with a message if bad */
+static unsigned long sim_number(const char* name, const char* arg) {
+    unsigned long value;
+    char          garbage;
+
+    if (sscanf(arg, "%lu%c", &value, &garbage) != 1) {
+        fprintf(stderr, "%s: argument to %s must be an unsigned integer.\n",
+                progname, name);
+        exit(1);
+    }
+    return value;
+}
+
+/**
+ * @brief Play game number @p i to the end with the autopilot
+ *
+ * Starts a one-player game on a fresh copy of the loaded maze the same
+ * way a key press during the attract loop does, then lets gamepilot()
+ * steer until gameattract() drops back to the intro or @p max_ticks
+ * ticks have passed.
+ */
+static void sim_play(unsigned long i) {
+    game_context_t* ctx;
+    sim_game_t*     g = games + i;
+    int             last_dots;
+
+    ctx      = game_context_clone(&game_main);
+    game_ctx = ctx;
+    /* spread consecutive seeds over the whole state space; 0 stays 0 */
+    game_ctx->pilot_rng = (uint32_t)(base_seed + i) * 0x9E3779B1U;
+
+    /* the first key skips the intro to the credit screen, the second
+     * starts the game */
+    gametick(ctx, -2, 0);
+    gametick(ctx, -2, 0);
+    last_dots = game_ctx->dots;
+    while (g->played < max_ticks) {
+        gameattract(ctx);
+        if (game_ctx->myman_intro)
+            break;
+        gamepilot();
+        gametick(ctx, -1, 0);
+        game_ctx->myman_sfx = 0UL;
+        if (game_ctx->dots > last_dots)
+            g->eaten += (unsigned long)(game_ctx->dots - last_dots);
+        last_dots = game_ctx->dots;
+        g->played++;
+    }
+    g->final_score = game_ctx->score;
+    g->final_level = game_ctx->level + 1;
+    g->capped      = !game_ctx->myman_intro;
+    game_ctx       = &game_main;
+    game_context_free(ctx);
+}
+
+static void* sim_worker(void* arg) {
+    unsigned long i;
+
+    (void)arg;
+    while ((i = atomic_fetch_add(&next_game, 1UL)) < n_games) {
+        sim_play(i);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Simulate every game on one maze and print its CSV row
+ *
+ * Runs in a forked child. Loads the default fonts and @p mazefile,
+ * plays n_games games on @p jobs worker threads and prints the means
+ * over all games.
+ *
+ * @return 0 on success, 1 if the maze or fonts could not be loaded
+ */
+static int sim_maze(const char* mazefile, unsigned long jobs) {
+    pthread_t*    workers;
+    unsigned long i, started;
+    unsigned long ticks = 0, dots_eaten = 0, capped = 0;
+    double        t0, t_run;
+    double        total_score = 0.0, total_level = 0.0;
+    long          max_score   = 0;
+
+    if (readfont(TILEFILE, &tile_w, &tile_h, tile, tile_used, &tile_flags,
+                 tile_color, &tile_args) ||
+        readfont(SPRITEFILE, &sprite_w, &sprite_h, sprite, sprite_used,
+                 &sprite_flags, sprite_color, &sprite_args))
+        return 1;
+    if (tile_args && parse_tile_args(TILEFILE, tile_args))
+        return 1;
+    if (sprite_args && parse_sprite_args(SPRITEFILE, sprite_args))
+        return 1;
+    gfx_reflect = reflect && !REFLECT_LARGE;
+    if (readmaze(mazefile, &maze_n, &maze_w, &maze_h, &game_ctx->maze,
+                 &maze_flags, &game_ctx->maze_color, &maze_args))
+        return 1;
+    if (maze_args && parse_maze_args(mazefile, maze_args))
+        return 1;
+    init_maze();
+    paint_walls(0);
+    gamereset();
+
+    games   = (sim_game_t*)calloc(n_games ? n_games : 1, sizeof(*games));
+    workers = (pthread_t*)malloc(jobs * sizeof(*workers));
+    if (!games || !workers) {
+        perror("malloc");
+        return 1;
+    }
+    atomic_init(&next_game, 0UL);
+    t0 = doubletime();
+    for (started = 0; started < jobs; started++) {
+        if (pthread_create(workers + started, NULL, sim_worker, NULL)) {
+            if (!started) {
+                perror("pthread_create");
+                return 1;
+            }
+            break;
+        }
+    }
+    for (i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    t_run = doubletime() - t0;
+
+    for (i = 0; i < n_games; i++) {
+        ticks += games[i].played;
+        dots_eaten += games[i].eaten;
+        capped += (unsigned long)games[i].capped;
+        total_score += (double)games[i].final_score;
+        total_level += (double)games[i].final_level;
+        if (games[i].final_score > max_score)
+            max_score = games[i].final_score;
+    }
+#define SIM_MEAN(total) (n_games ? ((double)(total) / n_games) : 0.0)
+    printf("%s,%lu,%lu,%lu,%.1f,%ld,%.1f,%.1f,%.2f,%lu,%lu,%.3f,%.0f\n",
+           mazefile, n_games, started, (unsigned long)base_seed,
+           SIM_MEAN(total_score), max_score, SIM_MEAN(ticks),
+           SIM_MEAN(dots_eaten), SIM_MEAN(total_level), capped, ticks, t_run,
+           (t_run > 0.0) ? (ticks / t_run) : 0.0);
+#undef SIM_MEAN
+    free(workers);
+    free(games);
+    games = NULL;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long jobs = 0;
+    char**        mazes;
+    size_t        n_mazes;
+    size_t        i;
+    int           failures = 0;
+    int           opt;
+
+    static char* default_maze[] = {MAZEFILE};
+
+    progname = (argc > 0) ? argv[0] : "glomph-sim";
+    while ((opt = getopt_long(argc, argv, "j:n:s:t:h", sim_options, NULL)) !=
+           -1) {
+        switch (opt) {
+        case 'j':
+            jobs = sim_number("--jobs", optarg);
+            if (!jobs || (jobs > SIM_MAX_JOBS)) {
+                fprintf(stderr, "%s: --jobs must be between 1 and %lu.\n",
+                        progname, SIM_MAX_JOBS);
+                return 1;
+            }
+            break;
+        case 'n':
+            n_games = sim_number("--games", optarg);
+            break;
+        case 's':
+            base_seed = (uint32_t)sim_number("--seed", optarg);
+            break;
+        case 't':
+            max_ticks = sim_number("--max-ticks", optarg);
+            break;
+        case 'h':
+            sim_usage();
+            return 0;
+        default:
+            fprintf(stderr,
+                    "Usage: %s [-j JOBS] [-n GAMES] [-s SEED] [-t TICKS] "
+                    "[MAZE...]\n",
+                    progname);
+            return 2;
+        }
+    }
+    if (!jobs) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        jobs = (cpus > 0) ? (unsigned long)cpus : 1UL;
+        if (jobs > SIM_MAX_JOBS)
+            jobs = SIM_MAX_JOBS;
+    }
+    if (optind < argc) {
+        mazes   = argv + optind;
+        n_mazes = (size_t)(argc - optind);
+    } else {
+        mazes   = default_maze;
+        n_mazes = 1;
+    }
+
+    for (i = 0; i < SPRITE_REGISTERS; i++) {
+        game_ctx->sprite_register_used[i]  = 0;
+        game_ctx->sprite_register_frame[i] = 0;
+        game_ctx->sprite_register_color[i] = 0x7;
+    }
+    for (i = 0; i < 256; i++) {
+        tile_color[i]   = 0x7;
+        sprite_color[i] = 0x7;
+    }
+
+    printf("maze,games,jobs,seed,mean_score,max_score,mean_ticks,mean_dots,"
+           "mean_level,capped,ticks,seconds,ticks_per_sec\n");
+    for (i = 0; i < n_mazes; i++) {
+        pid_t pid;
+        int   status;
+
+        fflush(stdout);
+        fflush(stderr);
+        pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (!pid) {
+            status = sim_maze(mazes[i], jobs);
+            fflush(stdout);
+            _exit(status);
+        }
+        if ((waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) ||
+            WEXITSTATUS(status)) {
+            fprintf(stderr, "%s: %s: failed\n", progname, mazes[i]);
+            failures++;
+        }
+    }
+    if (failures) {
+        fprintf(stderr, "%s: %d maze(s) failed\n", progname, failures);
+    }
+    return failures ? 1 : 0;
+}
@@ -57,7 +57,8 @@
  *
  * @return 0 on success, 1 on error
  *
- * @note Allocates memory for each character bitmap using malloc
+ * @note Allocates one block holding all 256 character bitmaps, which
+ * font[] points into
  * @note Used for tiles (readfont for tile[]), sprites (readfont for sprite[])
  * @see writefont, parse_tile_args, parse_sprite_args
  */
@@ -67,7 +68,7 @@ int readfont(const char* fontfile, int* w, int* h, const char** font, int* used,
     int   c, i, j, k;
     int   rw, rh;
     char  X;
-    char* font_dynamic[256];
+    char* glyphs;
 
     *args  = NULL;
     *flags = 0;
@@ -91,17 +92,15 @@ int readfont(const char* fontfile, int* w, int* h, const char** font, int* used,
     for (i = 0; i < 256; i++) {
         font[i] = NULL;
     }
+    glyphs = (char*)malloc((size_t)256 * rh * rw);
+    if (!glyphs) {
+        perror("malloc");
+        return 1;
+    }
+    memset((void*)glyphs, ' ', (size_t)256 * rh * rw);
     for (i = 0; i < 256; i++) {
-        font_dynamic[i] = (char*)malloc(rh * rw);
-        if (!font_dynamic[i]) {
-            perror("malloc");
-            for (j = 0; j < i; j++) {
-                free((void*)font_dynamic[j]);
-            }
-            return 1;
-        }
+        font[i] = glyphs + (size_t)i * rh * rw;
     }
-    memcpy((void*)font, (void*)font_dynamic, sizeof(font_dynamic));
     if (!feof(infile)) {
         c = fgetc_cp437_utf8(infile);
         if (c == '~') {
@@ -236,7 +235,7 @@ int readfont(const char* fontfile, int* w, int* h, const char** font, int* used,
             ungetc_cp437_utf8(c, infile);
         for (j = 0; j < rh; j++)
             for (k = 0; k < rw; k++)
-                font_dynamic[i][j * rw + k] = ' ';
+                glyphs[(i * rh + j) * rw + k] = ' ';
         for (j = 0; j < rh; j++) {
             while ((c = fgetc_cp437_utf8(infile)) != ':')
                 if (c == EOF) {
@@ -255,7 +254,7 @@ int readfont(const char* fontfile, int* w, int* h, const char** font, int* used,
             for (k = 0; (k < rw) && (c != '\v') && (c != '\f') && (c != '\n') &&
                         (c != '\r') && !feof(infile);
                  k++) {
-                font_dynamic[i][j * rw + k] = c;
+                glyphs[(i * rh + j) * rw + k] = c;
                 if ((c = fgetc_cp437_utf8(infile)) == EOF) {
                     if (feof(infile))
                         continue;
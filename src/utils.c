@@ -52,6 +52,7 @@
 #endif
 
 #include "globals.h"
+#include "game_context_aliases.h"
 
 /* command-line argument parser */
 #ifndef MYGETOPT_H
@@ -291,6 +292,15 @@ static struct option long_options_static[] = {{"version", 0, 0, 'V'},
                                               {"legal", 0, 0, 'L'},
                                               {"variant", 1, 0, 'v'},
                                               {"size", 1, 0, 'z'},
+                                              {"headless", 0, 0,
+                                               MYMAN_OPT_HEADLESS},
+                                              {"ticks", 1, 0, MYMAN_OPT_TICKS},
+                                              {"record", 1, 0,
+                                               MYMAN_OPT_RECORD},
+                                              {"replay", 1, 0,
+                                               MYMAN_OPT_REPLAY},
+                                              {"backend", 1, 0,
+                                               MYMAN_OPT_BACKEND},
                                               {0, 0, 0, 0}};
 struct option*       long_options          = long_options_static;
 
@@ -594,6 +604,54 @@ uint8_t cp437_sprite[256] = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
     0x00, 0x00, 0x00, 0x00};
 
+/* what each maze character means to movement: the CELL_* bits tested by
+ * ISOPEN(), ISDOOR(), ISDOT(), ISPELLET() and the ISZAP*() macros */
+const uint8_t maze_cell_class[256] = {
+    [' '] = CELL_OPEN,
+    ['!'] = CELL_OPEN,
+    ['l'] = CELL_OPEN,
+    ['~'] = CELL_OPEN,
+    ['A'] = CELL_OPEN,
+    ['B'] = CELL_OPEN,
+    ['C'] = CELL_OPEN,
+    ['D'] = CELL_OPEN,
+    ['E'] = CELL_OPEN,
+    ['F'] = CELL_OPEN,
+    ['G'] = CELL_OPEN,
+    ['H'] = CELL_OPEN,
+    ['I'] = CELL_OPEN,
+    ['J'] = CELL_OPEN,
+    ['K'] = CELL_OPEN,
+    ['L'] = CELL_OPEN,
+    ['M'] = CELL_OPEN,
+    ['N'] = CELL_OPEN,
+    ['O'] = CELL_OPEN,
+    ['P'] = CELL_OPEN,
+    ['Q'] = CELL_OPEN,
+    ['R'] = CELL_OPEN,
+    ['S'] = CELL_OPEN,
+    ['T'] = CELL_OPEN,
+    ['U'] = CELL_OPEN,
+    ['V'] = CELL_OPEN,
+    ['W'] = CELL_OPEN,
+    ['X'] = CELL_OPEN,
+    ['Y'] = CELL_OPEN,
+    ['Z'] = CELL_OPEN,
+    ['.'] = CELL_OPEN | CELL_DOT,
+    [249] = CELL_OPEN | CELL_DOT,
+    ['o'] = CELL_OPEN | CELL_PELLET,
+    [254] = CELL_OPEN | CELL_PELLET,
+    ['<'] = CELL_OPEN | CELL_ZAPLEFT,
+    [174] = CELL_OPEN | CELL_ZAPLEFT,
+    ['>'] = CELL_OPEN | CELL_ZAPRIGHT,
+    [175] = CELL_OPEN | CELL_ZAPRIGHT,
+    ['^'] = CELL_OPEN | CELL_ZAPUP,
+    ['v'] = CELL_OPEN | CELL_ZAPDOWN,
+    ['='] = CELL_DOOR,
+    [':'] = CELL_DOOR,
+    [240] = CELL_DOOR,
+    [255] = CELL_DOOR};
+
 const unsigned char udlr[256] = {
     /*00*/
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -1540,12 +1598,8 @@ char* mystrdup(const char* s) {
     return ret;
 }
 
-char*    maze             = NULL;
-char*    maze_color       = NULL;
-char*    blank_maze       = NULL;
-char*    blank_maze_color = NULL;
-uint8_t* dirty_cell       = NULL;
-bool     all_dirty        = false;
+char* blank_maze       = NULL;
+char* blank_maze_color = NULL;
 
 bool nogame = false;
 
@@ -1553,7 +1607,6 @@ int         maze_n;
 int         maze_w;
 int         maze_h;
 int         maze_flags;
-int         maze_level = 0;
 const char* maze_args  = NULL;
 
 int         tile_w;
@@ -1616,16 +1669,6 @@ const char* sprite[256] = {
 int sprite_used[256];
 int sprite_color[256];
 
-uint8_t sprite_register[SPRITE_REGISTERS];
-int     sprite_register_frame[SPRITE_REGISTERS];
-int sprite_register_x[SPRITE_REGISTERS], sprite_register_y[SPRITE_REGISTERS];
-int sprite_register_used[SPRITE_REGISTERS];
-int sprite_register_timer[SPRITE_REGISTERS];
-int sprite_register_color[SPRITE_REGISTERS];
-
-int ghost_dir[MAXGHOSTS], ghost_mem[MAXGHOSTS], ghost_man[MAXGHOSTS],
-    ghost_timer[MAXGHOSTS];
-uint8_t* home_dir = NULL;
 
 uint8_t gfx2(uint8_t c) {
     return (((reflect ^ gfx_reflect) && !REFLECT_LARGE)
@@ -1645,30 +1688,66 @@ uint8_t gfx0(uint8_t c, uint8_t* m) {
                : ((unsigned)(uint8_t)(c));
 }
 
+uint8_t* tile_atlas   = NULL;
+uint8_t* sprite_atlas = NULL;
+
+/* rasterize all 256 glyphs of a font through gfx0/gfx1/gfx2, first as
+ * drawn with reflect off and then with it on */
+static uint8_t* rasterize_font(uint8_t* atlas, const char** font,
+                               uint8_t* m, int w, int h) {
+    int reflect0 = reflect;
+    int gw       = gfx_reflect ? h : w;
+    int gh       = gfx_reflect ? w : h;
+    int plane, c, y, x;
+
+    free((void*)atlas);
+    atlas = (uint8_t*)malloc((size_t)2 * 256 * w * h);
+    if (!atlas) {
+        perror("malloc");
+        exit(1);
+    }
+    for (plane = 0; plane < 2; plane++) {
+        reflect = plane;
+        for (c = 0; c < 256; c++) {
+            uint8_t  c0   = gfx0((uint8_t)c, m);
+            uint8_t* cell = atlas + (size_t)(plane * 256 + c) * w * h;
+
+            for (y = 0; y < gh; y++)
+                for (x = 0; x < gw; x++)
+                    cell[y * gw + x] =
+                        font[c0] ? gfx2((uint8_t)gfx1(font, c0, y, x, w))
+                                 : (uint8_t)' ';
+        }
+    }
+    reflect = reflect0;
+    return atlas;
+}
+
+/**
+ * @brief Pre-render the tile and sprite fonts for gfx() and sgfx()
+ *
+ * Resolves the reflect_cp437/reflect_sprite remapping, the x/y swap and
+ * the reflected line-drawing glyphs for every character once, so each
+ * pixel lookup is a single load. Both reflect settings are kept, one
+ * after the other, so toggling reflect at run time needs no rebuild.
+ * Call after the fonts are loaded and gfx_reflect is set.
+ *
+ * @note Exits on allocation failure
+ * @see gfx, sgfx, readfont
+ */
+void init_gfx_atlas(void) {
+    tile_atlas =
+        rasterize_font(tile_atlas, tile, reflect_cp437, tile_w, tile_h);
+    sprite_atlas = rasterize_font(sprite_atlas, sprite, reflect_sprite,
+                                  sprite_w, sprite_h);
+}
+
 int           reflect     = 0;
 int           gfx_reflect = 0;
-long          myman_intro = 1;
-unsigned long myman_start = 0;
-unsigned long myman_demo  = 0;
-int           munched     = HERO;
-int           old_lines, old_cols, old_score, old_showlives, old_level;
-int           ignore_delay = 0;
-long          frameskip = 0, frameskip0 = 0, frameskip1 = 0;
-long          scrolling            = 0;
-long          frames               = 0;
-long          winning              = 1;
-unsigned long mymandelay           = MYMANDELAY;
-unsigned long mindelay             = MYMANDELAY / 2;
-int           ghost_eaten_timer    = 0;
-bool          paused               = false;
-long          intermission_running = 0;
-unsigned long myman_demo_setup     = 0;
-int           need_reset           = 0;
-int level = 0, intermission = 0, intermission_shown = 0, cycles = 0, score = 0,
-    dots = 0, points = 0, lives = LIVES, lives_used = 0, earned = 0, dying = 0,
-    dead = 0, deadpan = 0, myman_lines = 0, myman_columns = 0, oldplayer = 0,
-    player        = 1;
-long pellet_timer = 0, pellet_time = 0;
+long          frameskip0  = 0, frameskip1 = 0;
+long          scrolling   = 0;
+unsigned long mindelay    = MYMANDELAY / 2;
+int           lives = LIVES, myman_lines = 0, myman_columns = 0;
 
 
 char*         tmp_notice             = 0;
@@ -1725,15 +1804,11 @@ int           dirhero                = DIRHERO;
 long          scroll_offset_x0       = 0;
 long          scroll_offset_y0       = 0;
 int           msglen                 = 0;
-int           hero_dir;
 int*          total_dots = NULL;
 int*          pellets    = NULL;
 long          flip_to    = 0;
 int           debug      = 0;
 int           ghosts_p   = 0;
-unsigned long myman_sfx  = 0UL;
-int           showlives;
-int           visible_frame;
 
 #ifndef BONUSHERO
 #define BONUSHERO 10000
@@ -1754,11 +1829,12 @@ int           visible_frame;
 int bonus_score[8] = {100, 300, 500, 700, 1000, 2000, 3000, 5000};
 
 
-/* heuristic for rewriting maze tiles */
-long maze_visual(int n, int i, int j) {
+/* heuristic for rewriting maze tiles, for cell (i, j) of level n as
+ * stored in cells (maze or blank_maze) */
+long maze_visual_of(const char* cells, int n, int i, int j) {
     int c;
 
-    c = (int)(unsigned char)maze[(n * maze_h + i) * (maze_w + 1) + j];
+    c = (int)(unsigned char)cells[(n * maze_h + i) * (maze_w + 1) + j];
     switch (c) {
     case 0xb5:
         if ((!ISWALLUP(
@@ -1822,6 +1898,10 @@ long maze_visual(int n, int i, int j) {
     return c;
 }
 
+long maze_visual(int n, int i, int j) {
+    return maze_visual_of(maze, n, i, j);
+}
+
 
 
 static struct myman_environ_ent {
@@ -0,0 +1,395 @@
+/* vt.c - Direct VT/ANSI terminal output for Glomph Maze
+ * Copyright 1997-2009, Benjamin C. Wiley Sittler <bsittler@gmail.com>
+ * Copyright 2025, Michael Borck <michael@borck.dev>
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+/* fileno() and write() */
+#define _POSIX_C_SOURCE 200809L
+
+#include <curses.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "globals.h"
+#include "utils.h"
+
+extern chtype ascii_cp437[256];
+
+/* worst-case bytes one cell adds to the frame: cursor motion, an SGR
+ * sequence with 256-colour foreground and background, and the glyph */
+#define VT_CELL_MAX 64
+
+int vt_backend = 0; /* --backend=vt */
+int vt_active  = 0; /* a frame is being built, see vt_begin() */
+int vt_stale   = 0; /* curses no longer knows what the terminal shows */
+
+/* bytes sent for one CP437 byte, plus attributes the character set
+ * adds to it (ASCII mode shows some glyphs in reverse video) */
+typedef struct {
+    char          s[7];
+    unsigned char n;
+    unsigned long attrs;
+} vt_glyph_t;
+
+static int    vt_fd       = STDOUT_FILENO;
+static char*  vt_buf      = NULL;
+static size_t vt_len      = 0;
+static size_t vt_cap      = 0;
+static int    vt_clearing = 0; /* clear the screen when the frame starts */
+
+/* where vt_addch() draws next, and where the terminal cursor really
+ * is (vt_cur_y is -1 when unknown) */
+static int vt_y     = 0;
+static int vt_x     = 0;
+static int vt_cur_y = -1;
+static int vt_cur_x = -1;
+
+static unsigned long vt_cur_attrs   = 0;
+static int           vt_attrs_known = 0;
+
+static vt_glyph_t           vt_glyph[256];
+static int                  vt_glyph_mode = -1;
+static const unsigned long* vt_glyph_uni  = NULL;
+
+/**
+ * @brief Send frames to @p stream instead of standard output
+ *
+ * Used when curses itself writes somewhere other than the terminal,
+ * such as the off-screen terminal of --replay.
+ */
+void vt_output(FILE* stream) {
+    fflush(stream);
+    vt_fd = fileno(stream);
+}
+
+static void vt_reserve(size_t n) {
+    if (vt_len + n <= vt_cap)
+        return;
+    while (vt_len + n > vt_cap)
+        vt_cap = vt_cap ? (2 * vt_cap) : 4096;
+    vt_buf = (char*)realloc((void*)vt_buf, vt_cap);
+    if (!vt_buf) {
+        perror("realloc");
+        exit(1);
+    }
+}
+
+static void vt_str(const char* s) {
+    size_t n = strlen(s);
+
+    memcpy(vt_buf + vt_len, s, n);
+    vt_len += n;
+}
+
+static void vt_num(unsigned n) {
+    char   tmp[12];
+    size_t i = sizeof(tmp);
+
+    do {
+        tmp[--i] = (char)('0' + n % 10);
+        n /= 10;
+    } while (n);
+    memcpy(vt_buf + vt_len, tmp + i, sizeof(tmp) - i);
+    vt_len += sizeof(tmp) - i;
+}
+
+/* store code point u as UTF-8, replacing control characters */
+static void vt_encode(vt_glyph_t* g, unsigned long u) {
+    unsigned char* s = (unsigned char*)g->s;
+
+    if ((u < 0x20) || ((u >= 0x7F) && (u < 0xA0)) || (u > 0x10FFFF))
+        u = '?';
+    if (u < 0x80) {
+        s[0] = (unsigned char)u;
+        g->n = 1;
+    } else if (u < 0x800) {
+        s[0] = (unsigned char)(0xC0 | (u >> 6));
+        s[1] = (unsigned char)(0x80 | (u & 0x3F));
+        g->n = 2;
+    } else if (u < 0x10000) {
+        s[0] = (unsigned char)(0xE0 | (u >> 12));
+        s[1] = (unsigned char)(0x80 | ((u >> 6) & 0x3F));
+        s[2] = (unsigned char)(0x80 | (u & 0x3F));
+        g->n = 3;
+    } else {
+        s[0] = (unsigned char)(0xF0 | (u >> 18));
+        s[1] = (unsigned char)(0x80 | ((u >> 12) & 0x3F));
+        s[2] = (unsigned char)(0x80 | ((u >> 6) & 0x3F));
+        s[3] = (unsigned char)(0x80 | (u & 0x3F));
+        g->n = 4;
+    }
+}
+
+/* fill vt_glyph[] for the current character set options, following
+ * the same choices as my_addch() */
+static void vt_glyphs(void) {
+    int mode;
+    int i;
+
+    mode = (use_acs ? 1 : 0) | (use_raw ? 2 : 0) | (use_raw_ucs ? 4 : 0) |
+           (use_bullet_for_dots ? 8 : 0);
+    if ((mode == vt_glyph_mode) && (uni_cp437 == vt_glyph_uni))
+        return;
+    vt_glyph_mode = mode;
+    vt_glyph_uni  = uni_cp437;
+    for (i = 0; i < 256; i++) {
+        vt_glyph_t* g = vt_glyph + i;
+
+        g->attrs = 0;
+        if (use_acs && use_raw && !use_raw_ucs) {
+            /* raw CP437 bytes, as my_addch() sends them */
+            g->s[0] = (char)(unsigned char)(((i < 0x20) || (i == 0x7F)) ? '?'
+                                                                        : i);
+            g->n    = 1;
+        } else if (use_acs) {
+            vt_encode(g, uni_cp437[i]);
+        } else {
+            vt_encode(g, (unsigned long)(ascii_cp437[i] & A_CHARTEXT));
+            g->attrs = (unsigned long)(ascii_cp437[i] & ~A_CHARTEXT);
+        }
+    }
+}
+
+/* SGR colour parameter for curses colour c; base is 30 or 40 */
+static void vt_color(short c, unsigned base) {
+    if (c < 0)
+        return;
+    vt_str(";");
+    if (c < 8) {
+        vt_num(base + (unsigned)c);
+    } else if (c < 16) {
+        vt_num(base + 60 + (unsigned)c - 8);
+    } else {
+        vt_num(base + 8);
+        vt_str(";5;");
+        vt_num((unsigned)c);
+    }
+}
+
+static void vt_sgr(unsigned long attrs) {
+    short pair = (short)PAIR_NUMBER(attrs);
+
+    vt_str("\033[0");
+    if (attrs & A_BOLD)
+        vt_str(";1");
+    if (attrs & A_DIM)
+        vt_str(";2");
+    if (attrs & A_UNDERLINE)
+        vt_str(";4");
+    if (attrs & A_BLINK)
+        vt_str(";5");
+    if (attrs & (A_REVERSE | A_STANDOUT))
+        vt_str(";7");
+    if (attrs & A_INVIS)
+        vt_str(";8");
+    if (pair > 0) {
+        short fg, bg;
+
+        if (pair_content(pair, &fg, &bg) != ERR) {
+            vt_color(fg, 30);
+            vt_color(bg, 40);
+        }
+    }
+    vt_str("m");
+    vt_cur_attrs   = attrs;
+    vt_attrs_known = 1;
+}
+
+/* move the terminal cursor to (y, x) in as few bytes as possible */
+static void vt_goto(int y, int x) {
+    if (vt_cur_y == y) {
+        if (vt_cur_x == x)
+            return;
+        if (vt_cur_x < x) {
+            vt_str("\033[");
+            if (x - vt_cur_x > 1)
+                vt_num((unsigned)(x - vt_cur_x));
+            vt_str("C");
+            return;
+        }
+    } else if ((vt_cur_y >= 0) && (y == vt_cur_y + 1) && !x) {
+        vt_str("\r\n");
+        return;
+    }
+    vt_str("\033[");
+    vt_num((unsigned)y + 1);
+    vt_str(";");
+    vt_num((unsigned)x + 1);
+    vt_str("H");
+}
+
+static void vt_home_clear(void) {
+    vt_str("\033[0m\033[H\033[2J");
+    vt_cur_y       = 0;
+    vt_cur_x       = 0;
+    vt_cur_attrs   = 0;
+    vt_attrs_known = 1;
+}
+
+/**
+ * @brief Start building a frame
+ *
+ * Until vt_flush(), vt_addch() and vt_put() append to the frame buffer
+ * instead of curses drawing anything.
+ */
+void vt_begin(void) {
+    vt_glyphs();
+    vt_len         = 0;
+    vt_cur_y       = -1;
+    vt_attrs_known = 0;
+    vt_y           = 0;
+    vt_x           = 0;
+    vt_reserve(VT_CELL_MAX);
+    if (vt_clearing) {
+        vt_clearing = 0;
+        vt_home_clear();
+    }
+    vt_active = 1;
+}
+
+/**
+ * @brief Clear the terminal when the current or next frame is sent
+ *
+ * Anything already in the current frame is dropped. The caller resets
+ * the framebuffer with screen_fb_wipe().
+ */
+void vt_clear(void) {
+    if (!vt_active) {
+        vt_clearing = 1;
+        return;
+    }
+    vt_len = 0;
+    vt_home_clear();
+}
+
+void vt_move(int y, int x) {
+    vt_y = y;
+    vt_x = x;
+}
+
+void vt_getyx(int* y, int* x) {
+    *y = vt_y;
+    *x = vt_x;
+}
+
+/**
+ * @brief Append CP437 byte @p b at (@p y, @p x) to the frame
+ *
+ * Cells off the screen are ignored. After the last column the cursor
+ * is left at x == COLS: only "\r\n" or an absolute move follow it,
+ * since terminals differ on when they wrap.
+ */
+void vt_put(int y, int x, unsigned long b, unsigned long attrs) {
+    const vt_glyph_t* g;
+
+    if ((y < 0) || (x < 0) || (y >= LINES) || (x >= COLS))
+        return;
+    g     = vt_glyph + (b & 0xFF);
+    attrs = (attrs | g->attrs) & ~(unsigned long)(A_CHARTEXT | A_ALTCHARSET);
+    vt_reserve(VT_CELL_MAX);
+    vt_goto(y, x);
+    if ((!vt_attrs_known) || (attrs != vt_cur_attrs))
+        vt_sgr(attrs);
+    memcpy(vt_buf + vt_len, g->s, g->n);
+    vt_len += g->n;
+    vt_cur_y = y;
+    vt_cur_x = x + 1;
+}
+
+/**
+ * @brief Append a scroll of lines @p top to @p bot by @p n to the frame
+ *
+ * Sets the scroll region, scrolls it up @p n lines with SU (down with
+ * SD when @p n is negative) and resets the region. Attributes are
+ * reset first so the lines scrolled in are blank.
+ */
+void vt_scroll(int top, int bot, int n) {
+    if ((!n) || (top < 0) || (bot >= LINES) || (top >= bot))
+        return;
+    vt_reserve(VT_CELL_MAX);
+    if ((!vt_attrs_known) || vt_cur_attrs) {
+        vt_str("\033[0m");
+        vt_cur_attrs   = 0;
+        vt_attrs_known = 1;
+    }
+    vt_str("\033[");
+    vt_num((unsigned)top + 1);
+    vt_str(";");
+    vt_num((unsigned)bot + 1);
+    vt_str("r\033[");
+    vt_num((unsigned)((n > 0) ? n : -n));
+    vt_str((n > 0) ? "S\033[r" : "T\033[r");
+    /* setting the region homes the cursor */
+    vt_cur_y = 0;
+    vt_cur_x = 0;
+}
+
+/**
+ * @brief Draw @p b at the vt_move() position and step right one cell
+ *
+ * Cells the framebuffer says are already on the screen are skipped.
+ */
+int vt_addch(unsigned long b, unsigned long attrs) {
+    if (!screen_fb_put(vt_y, vt_x, b, attrs))
+        vt_put(vt_y, vt_x, b, attrs);
+    vt_x++;
+    return OK;
+}
+
+/**
+ * @brief Send the frame with one write() and leave frame mode
+ *
+ * Curses is told its window is up to date, so the next getch() does
+ * not repaint over the frame; vt_stale makes my_refresh() repaint the
+ * whole screen the next time curses draws.
+ */
+int vt_flush(void) {
+    size_t off = 0;
+    int    ret = OK;
+
+    vt_active = 0;
+    clearok(stdscr, FALSE);
+    untouchwin(stdscr);
+    if (!vt_len)
+        return OK;
+    vt_reserve(VT_CELL_MAX);
+    if ((!vt_attrs_known) || vt_cur_attrs)
+        vt_str("\033[0m");
+    while (off < vt_len) {
+        ssize_t n = write(vt_fd, vt_buf + off, vt_len - off);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            ret = ERR;
+            break;
+        }
+        off += (size_t)n;
+    }
+    vt_len   = 0;
+    vt_stale = 1;
+    return ret;
+}